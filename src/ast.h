@@ -158,6 +158,20 @@ namespace ast {
 				llvm::BasicBlock *llvm_match_block,
 				llvm::BasicBlock *llvm_no_match_block,
 				runnable_scope_t::ref *scope_if_true) const;
+
+		/* like resolve_match, but for when the ctor id of input_value is already known to be
+		 * this ctor's, so only the nested predicates need checking. any nested ctor predicates
+		 * in known_ctors are likewise already known to match their ctor. */
+		bool resolve_match_params(
+				llvm::IRBuilder<> &builder,
+				runnable_scope_t::ref scope,
+				life_t::ref life,
+				location_t value_location,
+				bound_var_t::ref input_value,
+				llvm::BasicBlock *llvm_match_block,
+				llvm::BasicBlock *llvm_no_match_block,
+				runnable_scope_t::ref *scope_if_true,
+				const std::set<const predicate_t *> *known_ctors=nullptr) const;
 		virtual std::string repr() const;
 		virtual void render(render_state_t &rs) const;
 		virtual match::Pattern::ref get_pattern(types::type_t::ref type, env_t::ref env) const;
@@ -280,6 +294,15 @@ namespace ast {
 				bool *returns) const;
 		virtual void render(render_state_t &rs) const;
 
+		/* when in_tail_position is set and this turns out to be a self call, it is emitted as a
+		 * jump back to the top of the function, and there is no value to return */
+		bound_var_t::ref resolve_call(
+				llvm::IRBuilder<> &builder,
+				scope_t::ref block_scope,
+				life_t::ref life,
+				types::type_t::ref expected_type,
+				bool in_tail_position) const;
+
 		ptr<expression_t> function_expr;
 		std::vector<ptr<expression_t>> params;
 	};
@@ -653,6 +676,10 @@ namespace ast {
 		identifier::ref extends_module;
 		token_t link_to_name;
 
+		/* linked functions that may block tell the runtime, so that other threads can collect
+		 * while they wait. see link_function_statement_t::resolve_expression */
+		bool blocking = false;
+
 		std::string get_function_name() const;
 	};
 
@@ -738,6 +765,35 @@ namespace ast {
 		ptr<block_t> block;
 	};
 
+	struct for_block_t : public statement_t {
+		typedef ptr<const for_block_t> ref;
+
+		static const syntax_kind_t SK = sk_for_block;
+
+		virtual void resolve_statement(
+				llvm::IRBuilder<> &builder,
+				scope_t::ref block_scope,
+				life_t::ref life,
+				runnable_scope_t::ref *new_scope,
+				bool *returns) const;
+		virtual void render(render_state_t &rs) const;
+
+		/* what the user wrote */
+		token_t param_token;
+		ptr<expression_t> iterable;
+		ptr<block_t> block;
+
+		/* the iterable gets evaluated once into this hidden variable, then exactly one of the
+		 * loops below is resolved against it */
+		ptr<var_decl_t> iterable_decl;
+
+		/* vectors and strs are walked by index, IntRanges by value, and everything else goes
+		 * through __iter__ and __next__ */
+		ptr<block_t> indexed_loop;
+		ptr<block_t> range_loop;
+		ptr<block_t> iterator_loop;
+	};
+
 	struct pattern_block_t : public item_t {
 		typedef ptr<const pattern_block_t> ref;
 		typedef std::vector<ref> refs;
@@ -553,9 +553,15 @@ function_scope_t::ref make_function_scope(
 	assert(llvm_function->arg_size() == dyncast<const types::type_args_t>(dyncast<const types::type_function_t>(function_var->type->get_type())->args)->args.size());
 	assert(llvm_function->arg_size() == params.size());
 
-	int i = 0;
-
-	for (auto &param : params) {
+	tail_call_target_t tail_call_target;
+	tail_call_target.llvm_function = llvm_function;
+	bool can_tail_call = !as_closure;
+
+	/* first, give every param a slot that self tail calls can store into */
+	std::vector<llvm::Value *> llvm_param_values;
+	std::vector<llvm::Value *> llvm_hidden_slots;
+	for (int i = 0; i < (int)params.size(); ++i) {
+		auto &param = params[i];
 		llvm::Value *llvm_param = &(*args++);
 		if (llvm_param->getName().str().size() == 0) {
 			llvm_param->setName(param.first);
@@ -572,9 +578,9 @@ function_scope_t::ref make_function_scope(
 
 		/* create a slot for the final param value to be determined */
 		llvm::Value *llvm_param_final = llvm_param;
+		llvm::Value *llvm_hidden_slot = nullptr;
 
 		if (allow_reassignment) {
-			param_type = type_ref(param_type);
 			/* create an alloca in order to be able to reassign the named
 			 * parameter to a new value. this does not mean that the parameter
 			 * is an out param, we are simply enabling reuse of the name */
@@ -589,19 +595,62 @@ function_scope_t::ref make_function_scope(
 						llvm_print(llvm_param).c_str()));
 			builder.CreateStore(llvm_param, llvm_alloca);	
 			llvm_param_final = llvm_alloca;
+
+			tail_call_target.llvm_param_slots.push_back(llvm_alloca);
+			tail_call_target.param_types.push_back(param.second->get_type());
+		} else if (can_tail_call) {
+			/* ref and maybe params can't be reassigned by name (that would defeat their null
+			 * checks), but a self tail call still needs somewhere to put their next value. they
+			 * are reloaded from this slot at the top of each iteration. nothing can collect
+			 * between the store and the reload, so the slot is not a gc root. */
+			llvm::AllocaInst *llvm_alloca = llvm_create_entry_block_alloca(
+					llvm_function, param.second, param.first + ".tail");
+			builder.CreateStore(llvm_param, llvm_alloca);
+			llvm_hidden_slot = llvm_alloca;
+
+			tail_call_target.llvm_param_slots.push_back(llvm_alloca);
+			tail_call_target.param_types.push_back(param.second->get_type());
+		}
+
+		llvm_param_values.push_back(llvm_param_final);
+		llvm_hidden_slots.push_back(llvm_hidden_slot);
+	}
+
+	if (can_tail_call) {
+		/* self calls in tail position jump back to here, just past the code that stored the
+		 * incoming params into their slots */
+		tail_call_target.llvm_loop_block = llvm::BasicBlock::Create(builder.getContext(),
+				"tail.call", llvm_function);
+		assert(!builder.GetInsertBlock()->getTerminator());
+		builder.CreateBr(tail_call_target.llvm_loop_block);
+		builder.SetInsertPoint(tail_call_target.llvm_loop_block);
+		new_scope->set_tail_call_target(tail_call_target);
+	}
+
+	/* then name the params in the new scope */
+	for (int i = 0; i < (int)params.size(); ++i) {
+		auto &param = params[i];
+		auto param_type = param.second->get_type();
+		llvm::Value *llvm_param_final = llvm_param_values[i];
+
+		bool allow_reassignment = llvm::isa<llvm::AllocaInst>(llvm_param_final);
+		if (allow_reassignment) {
+			param_type = type_ref(param_type);
+		} else if (llvm_hidden_slots[i] != nullptr) {
+			llvm_param_final = builder.CreateLoad(llvm_hidden_slots[i], param.first);
 		}
 
 		auto bound_stack_var_type = upsert_bound_type(builder,
 				scope, param_type);
 		auto param_var = bound_var_t::create(INTERNAL_LOC(), param.first, bound_stack_var_type,
-				llvm_param_final, make_iid(params[i++].first));
+				llvm_param_final, make_iid(param.first));
 
 
 		// REVIEW: why is this here?
 		// bound_type_t::ref return_type = get_function_return_type(builder, scope, function_var->type);
 
 		life->track_var(builder, scope, param_var, lf_function);
-		if (as_closure && i == (int)params.size()) {
+		if (as_closure && i == (int)params.size() - 1) {
 			auto closure_scope = dyncast<closure_scope_t>(scope); // ->get_closure_scope();
 			assert(closure_scope != nullptr);
 			assert(!allow_reassignment);
@@ -17,6 +17,7 @@
 
 namespace llvm {
 	FunctionPass *createZionGCLoweringPass(StructType *StackEntryTy, StructType *FrameMapTy);
+	FunctionPass *createZionStackPromotionPass();
 }
 
 #ifdef ZION_DEBUG
@@ -381,6 +382,14 @@ bool compiler_t::build_type_check_and_code_gen() {
 		type_check_program(builder, *program, *this);
 
 		debug_above(2, log(log_info, "type checking found no errors"));
+		if (debug_level() >= 2) {
+			int total = 0;
+			for (auto &pair : get_folded_constant_counts()) {
+				log(log_info, "folded %d constant expressions in %s", pair.second, pair.first.c_str());
+				total += pair.second;
+			}
+			log(log_info, "folded %d constant expressions in total", total);
+		}
 		return true;
 
 	} catch (user_error &e) {
@@ -494,6 +503,42 @@ void compiler_t::emit_built_program(std::string executable_filename) {
 	return;
 }
 
+bool use_gc_stack_maps() {
+	/* ZION_GC_STRATEGY=stackmap trades the shadow stack for a static frame table */
+	const char *strategy = getenv("ZION_GC_STRATEGY");
+	if (strategy == nullptr || strcmp(strategy, "shadow-stack") == 0) {
+		return false;
+	} else if (strcmp(strategy, "stackmap") == 0) {
+		return true;
+	} else {
+		throw user_error(INTERNAL_LOC(), "unknown ZION_GC_STRATEGY %s (expected shadow-stack or stackmap)", strategy);
+	}
+}
+
+void run_gc_stack_map_setup(
+		llvm::Module *llvm_module,
+		llvm::StructType *llvm_stack_entry_type)
+{
+	/* leave the gcroot allocas alone. the code generator records where they live at each call
+	 * (see zion_gc_stackmap.cpp), which only works if every frame keeps its frame pointer. */
+	for (auto &F : *llvm_module) {
+		if (F.hasGC()) {
+			F.setGC(GC_STACK_MAP_STRATEGY);
+			F.addFnAttr("no-frame-pointer-elim", "true");
+		}
+	}
+
+	/* the runtime still refers to the (now always empty) shadow stack */
+	llvm::GlobalVariable *head = llvm_module->getGlobalVariable("llvm_gc_root_chain");
+	if (head != nullptr && head->isDeclaration()) {
+		llvm::PointerType *stack_entry_ptr_type = llvm::PointerType::getUnqual(llvm_stack_entry_type);
+		head->setInitializer(llvm::Constant::getNullValue(stack_entry_ptr_type));
+		head->setLinkage(llvm::GlobalValue::LinkOnceAnyLinkage);
+		head->setThreadLocal(true);
+	}
+	dump_llir(llvm_module, "jit.llir");
+}
+
 void run_gc_lowering(
 		llvm::Module *llvm_module,
 		llvm::StructType *llvm_stack_frame_map_type,
@@ -503,6 +548,21 @@ void run_gc_lowering(
 	assert(llvm_stack_frame_map_type != nullptr);
 	assert(llvm_stack_entry_type != nullptr);
 
+	/* keep objects that never leave their function off of the heap. this must run before the
+	 * roots are lowered, while they are still plain gcroot allocas. */
+	auto promotion_FPM = llvm::make_unique<llvm::legacy::FunctionPassManager>(llvm_module);
+	promotion_FPM->add(llvm::createZionStackPromotionPass());
+	promotion_FPM->doInitialization();
+	for (auto &F : *llvm_module) {
+		promotion_FPM->run(F);
+	}
+	promotion_FPM->doFinalization();
+
+	if (use_gc_stack_maps()) {
+		run_gc_stack_map_setup(llvm_module, llvm_stack_entry_type);
+		return;
+	}
+
 	// Create a function pass manager.
 	auto FPM = llvm::make_unique<llvm::legacy::FunctionPassManager>(llvm_module);
 
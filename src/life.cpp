@@ -2,6 +2,7 @@
 #include "life.h"
 #include "callable.h"
 #include "unification.h"
+#include "ast.h"
 #include <iostream>
 
 
@@ -64,6 +65,39 @@ struct defer_call_trackable_t : public trackable_t {
 	}
 };
 
+struct defer_statement_trackable_t : public trackable_t {
+	defer_statement_trackable_t(scope_t::ref block_scope, ptr<const ast::statement_t> statement) :
+		block_scope(block_scope), statement(statement)
+	{
+	}
+
+	const scope_t::ref block_scope;
+	const ptr<const ast::statement_t> statement;
+
+	std::string str() const override {
+		return statement->str();
+	}
+
+	virtual location_t get_location() const override {
+		return statement->get_location();
+	}
+
+	virtual void release(llvm::IRBuilder<> &builder, scope_t::ref scope) const override {
+		auto fake_life = (
+				make_ptr<life_t>(lf_function)
+				->new_life(lf_block)
+				->new_life(lf_statement));
+
+		/* the statement is resolved in the scope where it was deferred, not the one we are
+		 * leaving from, so that it sees the same names wherever it ends up inlined */
+		bool returns = false;
+		statement->resolve_statement(builder, block_scope, fake_life, nullptr, &returns);
+		assert(!returns);
+
+		fake_life->release_vars(builder, block_scope, lf_function);
+	}
+};
+
 life_form_t::life_form_t(int val) : val(val) {
 }
 
@@ -177,6 +211,19 @@ void life_t::defer_call(
 	}
 }
 
+void life_t::defer_statement(
+		llvm::IRBuilder<> &builder,
+		scope_t::ref block_scope,
+		ptr<const ast::statement_t> statement)
+{
+	if (this->life_form == lf_block) {
+		values.push_front(std::make_unique<defer_statement_trackable_t>(block_scope, statement));
+	} else {
+		assert(this->former_life != nullptr && "We found a track_in_life_form for a life_form that is not on the stack.");
+		this->former_life->defer_statement(builder, block_scope, statement);
+	}
+}
+
 void life_t::track_var(
 		llvm::IRBuilder<> &builder,
 		scope_t::ref scope,
@@ -200,6 +247,12 @@ void life_t::track_var(
 			return;
 		}
 
+		if (llvm::isa<llvm::Constant>(value->get_llvm_value())) {
+			/* constants (null, tags, str literals) never live on the heap */
+			debug_above(9, log("not tracking %s because it is a constant", value->str().c_str()));
+			return;
+		}
+
 		/* ensure there is a slot in the stack map for this heap pointer */
 		value = llvm_stack_map_value(builder, scope, value);
 
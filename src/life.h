@@ -30,6 +30,10 @@ private:
 	int val;
 };
 
+namespace ast {
+	struct statement_t;
+}
+
 struct trackable_t {
 	virtual ~trackable_t() {}
 	virtual std::string str() const = 0;
@@ -62,6 +66,13 @@ struct life_t : std::enable_shared_from_this<life_t> {
 			scope_t::ref scope,
 			bound_var_t::ref value);
 
+	/* track the need to run a statement at the end of a life. the statement is resolved in
+	 * block_scope at each place the life is released, rather than being called as a closure. */
+	void defer_statement(
+			llvm::IRBuilder<> &builder,
+			scope_t::ref block_scope,
+			ptr<const ast::statement_t> statement);
+
 	/* release values down to and including a particular life_form level */
 	int release_vars(
 			llvm::IRBuilder<> &builder,
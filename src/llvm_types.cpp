@@ -257,7 +257,10 @@ bound_type_t::ref create_bound_tuple_type(
 		const ptr<const types::type_tuple_t> &tuple_type)
 {
 	auto program_scope = scope->get_program_scope();
-	auto expansion = type_ptr(type_managed(type_struct(tuple_type->dimensions, {})));
+	types::type_t::ref expansion = type_struct(tuple_type->dimensions, {});
+	if (!types::is_value_tuple(tuple_type, scope)) {
+		expansion = type_ptr(type_managed(expansion));
+	}
 
 	auto bound_structural_type = upsert_bound_type(builder, scope, expansion);
 	auto bound_type = bound_type_t::create(tuple_type,
@@ -505,6 +508,12 @@ bound_type_t::ref create_bound_maybe_type(
 					bound_just_type->get_llvm_specific_type());
 			program_scope->put_bound_type(bound_type);
 			return bound_type;
+		} else if (types::is_value_tuple(maybe->just, scope)) {
+			/* tuples of plain values are passed as structs. their optional form is the boxed
+			 * Maybe ADT, where Just(t) holds the struct inline */
+			throw user_error(maybe->get_location(),
+					"%s is passed by value and cannot be a native maybe. use (%s)? instead",
+					maybe->just->str().c_str(), maybe->just->str().c_str());
 		} else {
 			throw user_error(bound_just_type->get_location(),
 					"maybe types must wrap pointers. %s is not a pointer",
@@ -1128,6 +1137,21 @@ bound_var_t::ref get_or_create_tuple_ctor(
 	int index = 0;
 
 	llvm::Function *llvm_function = llvm::cast<llvm::Function>(function->get_llvm_value());
+
+	/* objects that hold numbers and pointers and need no finalizer can live on the stack of any
+	 * caller they don't escape from (see zion_stack_promotion.cpp) */
+	bool promotable = (dtor_fn == nullptr);
+	for (auto &arg : args) {
+		llvm::Type *llvm_arg_type = arg->get_llvm_specific_type();
+		if (!llvm_arg_type->isIntegerTy() && !llvm_arg_type->isFloatingPointTy()
+				&& !llvm_arg_type->isPointerTy()) {
+			promotable = false;
+		}
+	}
+	if (promotable) {
+		llvm_function->addFnAttr(PROMOTABLE_CTOR_ATTR);
+	}
+
 	llvm::Function::arg_iterator args_iter = llvm_function->arg_begin();
 	while (args_iter != llvm_function->arg_end()) {
 		llvm::Value *llvm_param = &*args_iter++;
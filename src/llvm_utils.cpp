@@ -14,6 +14,8 @@
 #include "unification.h"
 
 const char *GC_STRATEGY = "zion";
+const char *GC_STACK_MAP_STRATEGY = "zion-stackmap";
+const char *PROMOTABLE_CTOR_ATTR = "zion-promotable-ctor";
 
 
 llvm::Value *llvm_create_global_string(llvm::IRBuilder<> &builder, std::string value) {
@@ -192,6 +194,17 @@ bound_var_t::ref create_callsite(
 			if (auto args = dyncast<const types::type_args_t>(function_type->args)) {
 				auto coerced_parameter_values = get_llvm_values(builder,
 						scope, life, location, args, arguments);
+
+				if (llvm::Value *llvm_inlined_value = llvm_maybe_inline_builtin(
+							builder, function, coerced_parameter_values))
+				{
+					/* builtins only deal in numbers, so there is nothing to track */
+					return bound_var_t::create(INTERNAL_LOC(), name,
+							get_function_return_type(builder, scope, function->type),
+							llvm_inlined_value,
+							make_type_id_code_id(location, name));
+				}
+
 				llvm::CallInst *llvm_call_inst = llvm_create_call_inst(
 						builder, location, function, coerced_parameter_values);
 
@@ -217,6 +230,74 @@ bound_var_t::ref create_callsite(
 	}
 }
 
+llvm::Value *llvm_maybe_inline_builtin(
+		llvm::IRBuilder<> &builder,
+		ptr<const bound_var_t> callee,
+		const std::vector<llvm::Value *> &llvm_values)
+{
+	llvm::Function *llvm_callee_fn = llvm::dyn_cast<llvm::Function>(callee->get_llvm_value());
+	if (llvm_callee_fn == nullptr || !llvm_callee_fn->isDeclaration()) {
+		return nullptr;
+	}
+
+	/* these are the link targets in lib/int.zion and lib/float.zion. the C versions are still
+	 * linked in for anyone taking their address, or calling them from C. */
+	typedef llvm::IRBuilder<> B;
+	static struct {
+		const char *link_name;
+		llvm::Value *(*emit)(B &builder, llvm::Value *x, llvm::Value *y);
+	} builtins[] = {
+		{"__float_neg", [](B &b, llvm::Value *x, llvm::Value *) { return b.CreateFNeg(x); }},
+		{"__float_pos", [](B &b, llvm::Value *x, llvm::Value *) { return x; }},
+		{"__float_float", [](B &b, llvm::Value *x, llvm::Value *) { return x; }},
+		{"__float_int", [](B &b, llvm::Value *x, llvm::Value *) { return b.CreateSIToFP(x, b.getDoubleTy()); }},
+		{"__int_float", [](B &b, llvm::Value *x, llvm::Value *) { return b.CreateFPToSI(x, b.getInt64Ty()); }},
+		{"__int_neg", [](B &b, llvm::Value *x, llvm::Value *) { return b.CreateNeg(x); }},
+		{"__int_pos", [](B &b, llvm::Value *x, llvm::Value *) { return x; }},
+		{"__int_int", [](B &b, llvm::Value *x, llvm::Value *) { return x; }},
+		{"__float_plus_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFAdd(x, y); }},
+		{"__float_minus_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFSub(x, y); }},
+		{"__float_times_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFMul(x, y); }},
+		{"__float_divide_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFDiv(x, y); }},
+		{"__int_plus_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFAdd(b.CreateSIToFP(x, y->getType()), y); }},
+		{"__int_minus_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFSub(b.CreateSIToFP(x, y->getType()), y); }},
+		{"__int_times_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFMul(b.CreateSIToFP(x, y->getType()), y); }},
+		{"__int_divide_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFDiv(b.CreateSIToFP(x, y->getType()), y); }},
+		{"__float_plus_int", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFAdd(x, b.CreateSIToFP(y, x->getType())); }},
+		{"__float_minus_int", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFSub(x, b.CreateSIToFP(y, x->getType())); }},
+		{"__float_times_int", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFMul(x, b.CreateSIToFP(y, x->getType())); }},
+		{"__float_divide_int", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFDiv(x, b.CreateSIToFP(y, x->getType())); }},
+		/* these match C's comparisons, so only != is true when either side is NaN */
+		{"__float_eq_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFCmpOEQ(x, y); }},
+		{"__float_ineq_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFCmpUNE(x, y); }},
+		{"__float_gt_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFCmpOGT(x, y); }},
+		{"__float_gte_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFCmpOGE(x, y); }},
+		{"__float_lt_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFCmpOLT(x, y); }},
+		{"__float_lte_float", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFCmpOLE(x, y); }},
+		{"__float_lt_int", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFCmpOLT(x, b.CreateSIToFP(y, x->getType())); }},
+		{"__float_lte_int", [](B &b, llvm::Value *x, llvm::Value *y) { return b.CreateFCmpOLE(x, b.CreateSIToFP(y, x->getType())); }},
+	};
+
+	std::string link_name = llvm_callee_fn->getName().str();
+	for (size_t i=0; i<sizeof(builtins)/sizeof(builtins[0]); ++i) {
+		if (link_name == builtins[i].link_name) {
+			assert(llvm_values.size() == 1 || llvm_values.size() == 2);
+			llvm::Value *llvm_value = builtins[i].emit(
+					builder,
+					llvm_values[0],
+					llvm_values.size() == 2 ? llvm_values[1] : nullptr);
+
+			/* comparisons come back as i1, but the C versions return a zion_bool_t */
+			llvm::Type *llvm_return_type = llvm_callee_fn->getReturnType();
+			if (llvm_value->getType() != llvm_return_type) {
+				llvm_value = builder.CreateZExt(llvm_value, llvm_return_type);
+			}
+			return llvm_value;
+		}
+	}
+	return nullptr;
+}
+
 llvm::CallInst *llvm_create_call_inst(
 		llvm::IRBuilder<> &builder,
 		location_t location,
@@ -786,6 +867,39 @@ bound_var_t::ref create_global_str(
 	return str_literal;
 }
 
+bool llvm_get_global_str_value(llvm::Value *llvm_value, std::string &value) {
+	/* reads back the value of a str made by create_global_str. the str_literal_t points at an
+	 * owning buffer, which points at the bytes. */
+	auto llvm_str_literal = llvm::dyn_cast<llvm::GlobalVariable>(llvm_value->stripPointerCasts());
+	if (llvm_str_literal == nullptr || !llvm_str_literal->isConstant() || !llvm_str_literal->hasInitializer()) {
+		return false;
+	}
+
+	auto llvm_str_data = llvm::dyn_cast<llvm::ConstantStruct>(llvm_str_literal->getInitializer());
+	if (llvm_str_data == nullptr || llvm_str_data->getNumOperands() != 9
+			|| llvm_str_data->getOperand(0)->getName() != "__internal.str_literal_type_info") {
+		return false;
+	}
+
+	auto llvm_owning_buffer = llvm::dyn_cast<llvm::GlobalVariable>(llvm_str_data->getOperand(6)->stripPointerCasts());
+	auto llvm_offset = llvm::dyn_cast<llvm::ConstantInt>(llvm_str_data->getOperand(7));
+	auto llvm_length = llvm::dyn_cast<llvm::ConstantInt>(llvm_str_data->getOperand(8));
+	if (llvm_owning_buffer == nullptr || !llvm_owning_buffer->hasInitializer()
+			|| llvm_offset == nullptr || llvm_length == nullptr) {
+		return false;
+	}
+
+	auto llvm_buffer_data = llvm::dyn_cast<llvm::ConstantStruct>(llvm_owning_buffer->getInitializer());
+	llvm::StringRef bytes;
+	if (llvm_buffer_data == nullptr || llvm_buffer_data->getNumOperands() != 8
+			|| !llvm::getConstantStringInfo(llvm_buffer_data->getOperand(6), bytes, 0, false /*TrimAtNul*/)) {
+		return false;
+	}
+
+	value = bytes.substr(llvm_offset->getZExtValue(), llvm_length->getZExtValue()).str();
+	return true;
+}
+
 llvm::Constant *llvm_create_struct_instance(
 		std::string var_name,
 		llvm::Module *llvm_module,
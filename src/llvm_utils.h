@@ -8,6 +8,8 @@
 #define DTOR_FN_INDEX 1
 
 extern const char *GC_STRATEGY;
+extern const char *GC_STACK_MAP_STRATEGY;
+extern const char *PROMOTABLE_CTOR_ATTR;
 
 struct compiler_t;
 struct life_t;
@@ -34,6 +36,13 @@ llvm::CallInst *llvm_create_call_inst(
 		ptr<const bound_var_t> callee,
 		std::vector<llvm::Value *> llvm_values);
 
+/* if callee is one of the numeric builtins in rt_int.c or rt_float.c, emit its body inline and
+ * return the result. otherwise, return null. */
+llvm::Value *llvm_maybe_inline_builtin(
+		llvm::IRBuilder<> &builder,
+		ptr<const bound_var_t> callee,
+		const std::vector<llvm::Value *> &llvm_values);
+
 llvm::Constant *llvm_create_struct_instance(
 		std::string var_name,
 		llvm::Module *llvm_module,
@@ -50,7 +59,9 @@ llvm::ConstantInt *llvm_create_int32(llvm::IRBuilder<> &builder, int32_t value);
 llvm::Value *llvm_create_double(llvm::IRBuilder<> &builder, double value);
 llvm::GlobalVariable *llvm_get_global(llvm::Module *llvm_module, std::string name, llvm::Constant *llvm_constant, bool is_constant);
 llvm::Value *llvm_create_global_string(llvm::IRBuilder<> &builder, std::string value);
+llvm::Constant *llvm_create_global_string_constant(llvm::IRBuilder<> &builder, llvm::Module &M, std::string str);
 bound_var_t::ref create_global_str(llvm::IRBuilder<> &builder, scope_t::ref scope, location_t location, std::string value);
+bool llvm_get_global_str_value(llvm::Value *llvm_value, std::string &value);
 llvm::Module *llvm_get_module(llvm::IRBuilder<> &builder);
 llvm::Function *llvm_get_function(llvm::IRBuilder<> &builder);
 std::string llvm_print_module(llvm::Module &module);
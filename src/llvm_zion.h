@@ -4,6 +4,7 @@
 #error Probably we should include LLVM first.
 #endif
 
+#include <llvm/Analysis/ValueTracking.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/GenericValue.h>
 #include <llvm/ExecutionEngine/MCJIT.h>
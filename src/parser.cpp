@@ -268,11 +268,28 @@ ptr<statement_t> parse_for_block(parse_state_t &ps) {
 	auto expr = expression_t::parse(ps);
 	auto block = block_t::parse(ps, false /*expression_means_return*/);
 
+	/* the iterable is evaluated exactly once, into a hidden variable. the type checker then picks
+	 * one of the loops below to run over it, depending on its type (see for_block_t) */
+	auto for_block = create<for_block_t>(for_token);
+	for_block->param_token = param_token;
+	for_block->iterable = expr;
+	for_block->block = block;
+
+	auto iterable_decl = create<var_decl_t>(token_t{expr->get_location(), tk_identifier, types::gensym(INTERNAL_LOC())->get_name()});
+	iterable_decl->is_let_var = true;
+	iterable_decl->type = type_variable(expr->get_location());
+	iterable_decl->initializer = expr;
+	for_block->iterable_decl = iterable_decl;
+
+	auto iterable_ref = [&] () {
+		return create<reference_expr_t>(iterable_decl->token);
+	};
+
 	auto iter_token = token_t{expr->get_location(), tk_identifier, "__iter__"};
 	auto iter_ref = create<reference_expr_t>(iter_token);
 	auto iter_callsite = create<callsite_expr_t>(iter_token);
 	iter_callsite->function_expr = iter_ref;
-	iter_callsite->params.push_back(expr);
+	iter_callsite->params.push_back(iterable_ref());
 
 	auto iter_decl = create<var_decl_t>(token_t{becomes_token.location, tk_identifier, types::gensym(INTERNAL_LOC())->get_name()});
 	iter_decl->is_let_var = true;
@@ -313,11 +330,92 @@ ptr<statement_t> parse_for_block(parse_state_t &ps) {
 	while_loop->block = while_block;
 	while_loop->condition = create<reference_expr_t>(token_t{becomes_token.location, tk_identifier, "true"});
 
-	ptr<block_t> outer_block = create<block_t>(for_token);
-	outer_block->statements.push_back(iter_decl);
-	outer_block->statements.push_back(while_loop);
-	// log_location(log_info, outer_block->get_location(), "created %s", outer_block->str().c_str());
-	return outer_block;
+	/* the iterator protocol, for everything else:
+	 *
+	 *   let iter = __iter__(iterable)
+	 *   while true {
+	 *     match __next__(iter) {
+	 *       Just(x) { block }
+	 *       Nothing { break }
+	 *     }
+	 *   }
+	 */
+	auto iterator_loop = create<block_t>(for_token);
+	iterator_loop->statements.push_back(iter_decl);
+	iterator_loop->statements.push_back(while_loop);
+	for_block->iterator_loop = iterator_loop;
+
+	/* builds a counted loop that allocates nothing per iteration:
+	 *
+	 *   var i = start
+	 *   while i < lim {
+	 *     let x = item
+	 *     i += step
+	 *     block
+	 *   }
+	 */
+	auto index_token = token_t{for_token.location, tk_identifier, types::gensym(INTERNAL_LOC())->get_name()};
+	auto index_ref = [&] () {
+		return create<reference_expr_t>(index_token);
+	};
+	auto iterable_member = [&] (const char *name) -> ptr<expression_t> {
+		auto dot_expr = create<dot_expr_t>(for_token);
+		dot_expr->lhs = iterable_ref();
+		dot_expr->rhs = token_t{for_token.location, tk_identifier, name};
+		return dot_expr;
+	};
+	auto counted_loop = [&] (ptr<expression_t> start, ptr<expression_t> lim, ptr<expression_t> item, ptr<expression_t> step) {
+		auto index_decl = create<var_decl_t>(index_token);
+		index_decl->is_let_var = false;
+		index_decl->type = type_variable(for_token.location);
+		index_decl->initializer = start;
+
+		auto condition = create<binary_operator_t>(token_t{for_token.location, tk_lt, "<"});
+		condition->function_name = "__lt__";
+		condition->lhs = index_ref();
+		condition->rhs = lim;
+
+		auto item_decl = create<var_decl_t>(param_token);
+		item_decl->is_let_var = true;
+		item_decl->type = type_variable(param_token.location);
+		item_decl->initializer = item;
+
+		/* step before the body, so that continue moves on to the next item */
+		auto advance = create<plus_assignment_t>(token_t{for_token.location, tk_plus_eq, "+="});
+		advance->lhs = index_ref();
+		advance->rhs = step;
+
+		auto body = create<block_t>(block->token);
+		body->statements.push_back(item_decl);
+		body->statements.push_back(advance);
+		body->statements.push_back(block);
+
+		auto loop = create<while_block_t>(for_token);
+		loop->condition = condition;
+		loop->block = body;
+
+		auto counted_block = create<block_t>(for_token);
+		counted_block->statements.push_back(index_decl);
+		counted_block->statements.push_back(loop);
+		return counted_block;
+	};
+
+	/* vectors and strs: for i in [0, len(iterable)), x = iterable[i] */
+	auto zero = create<literal_expr_t>(token_t{for_token.location, tk_integer, "0"});
+	auto one = create<literal_expr_t>(token_t{for_token.location, tk_integer, "1"});
+	auto len_token = token_t{for_token.location, tk_identifier, "len"};
+	auto len_callsite = create<callsite_expr_t>(len_token);
+	len_callsite->function_expr = create<reference_expr_t>(len_token);
+	len_callsite->params.push_back(iterable_ref());
+	auto index_expr = create<array_index_expr_t>(for_token);
+	index_expr->lhs = iterable_ref();
+	index_expr->start = index_ref();
+	for_block->indexed_loop = counted_loop(zero, len_callsite, index_expr, one);
+
+	/* IntRange: for i in [first, lim) by step, x = i */
+	for_block->range_loop = counted_loop(iterable_member("first"), iterable_member("lim"),
+			index_ref(), iterable_member("step"));
+	return for_block;
 }
 
 ptr<statement_t> defer_t::parse(parse_state_t &ps) {
@@ -1335,6 +1433,7 @@ ptr<function_decl_t> function_decl_t::parse(
 {
 	location_t attributes_location;
 	identifier::ref extends_module;
+	bool blocking = false;
 
 	if (ps.token.tk == tk_lsquare) {
 		if (within_expression) {
@@ -1353,6 +1452,10 @@ ptr<function_decl_t> function_decl_t::parse(
 			extends_module = make_code_id(ps.token);
 			ps.advance();
 			chomp_token(tk_rsquare);
+		} else if (ps.token.is_ident(K(blocking))) {
+			blocking = true;
+			ps.advance();
+			chomp_token(tk_rsquare);
 		} else {
 			throw user_error(ps.token.location, "expected module injection");
 		}
@@ -1414,6 +1517,7 @@ ptr<function_decl_t> function_decl_t::parse(
 	function_decl->function_type = parsed_type;
 	function_decl->extends_module = extends_module;
 	function_decl->link_to_name = name_token;
+	function_decl->blocking = blocking;
 	return function_decl;
 }
 
@@ -1421,6 +1525,9 @@ ptr<function_defn_t> function_defn_t::parse(parse_state_t &ps, bool within_expre
 	auto function_decl = function_decl_t::parse(ps, within_expression, nullptr);
 
 	assert(function_decl != nullptr);
+	if (function_decl->blocking) {
+		throw user_error(function_decl->get_location(), "only linked functions can be marked " c_id("blocking"));
+	}
 	type_macros_restorer_t type_macros_restorer(ps.type_macros);
 
 	/* temporarily inject free type variables from function declaration into the function parsing context.
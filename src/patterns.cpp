@@ -9,6 +9,168 @@
 #include <iostream>
 #include "unification.h"
 #include "coercions.h"
+#include "patterns.h"
+
+namespace {
+	/* a path from the matched value down to one of its nested members. each step is the index of
+	 * a param of the ctor found at that point. the empty column is the matched value itself. */
+	typedef std::vector<int> column_t;
+
+	struct pattern_arm_t {
+		ast::pattern_block_t::ref pattern_block;
+
+		/* set when the top-level predicate of this arm is a ctor predicate */
+		ast::ctor_predicate_t::ref ctor_predicate;
+
+		/* what this arm covers, as check_patterns sees it */
+		match::Pattern::ref pattern;
+
+		/* set once the block for this arm has been emitted */
+		llvm::BasicBlock *llvm_matched_block = nullptr;
+	};
+}
+
+static bool has_single_ctor(runnable_scope_t::ref scope, types::type_t::ref type) {
+	/* a data type with only one ctor never needs its ctor id checked. every value of that type
+	 * was made by that ctor. */
+	types::type_data_t::ref data_type = dyncast<const types::type_data_t>(type->eval(scope));
+	return data_type != nullptr && data_type->ctor_pairs.size() == 1;
+}
+
+static ptr<const match::CtorPattern> ctor_pattern_at(match::Pattern::ref pattern, const column_t &column) {
+	/* the ctor that pattern requires in column, or null if it does not refute that column */
+	for (auto index : column) {
+		auto ctor_pattern = pattern->asCtorPattern();
+		if (ctor_pattern == nullptr) {
+			return nullptr;
+		}
+		pattern = ctor_pattern->cpv.args[index];
+	}
+	return pattern->asCtorPattern();
+}
+
+static ast::predicate_t::ref predicate_at(ast::predicate_t::ref predicate, const column_t &column) {
+	for (auto index : column) {
+		auto ctor_predicate = dyncast<const ast::ctor_predicate_t>(predicate);
+		assert(ctor_predicate != nullptr);
+		predicate = ctor_predicate->params[index];
+	}
+	return predicate;
+}
+
+static types::type_t::ref column_type(
+		runnable_scope_t::ref scope,
+		types::type_t::ref type,
+		match::Pattern::ref pattern,
+		const column_t &column)
+{
+	/* find the type of column by following the ctors that pattern names on the way down */
+	for (auto index : column) {
+		auto ctor_pattern = pattern->asCtorPattern();
+		types::type_data_t::ref data_type = dyncast<const types::type_data_t>(type->eval(scope));
+		if (ctor_pattern == nullptr || data_type == nullptr) {
+			return nullptr;
+		}
+
+		type = nullptr;
+		for (auto ctor_pair : data_type->ctor_pairs) {
+			if (ctor_pair.first.text == ctor_pattern->cpv.name) {
+				type = ctor_pair.second->args[index];
+			}
+		}
+		if (type == nullptr) {
+			return nullptr;
+		}
+		pattern = ctor_pattern->cpv.args[index];
+	}
+	return type;
+}
+
+static bound_var_t::ref extract_column(
+		llvm::IRBuilder<> &builder,
+		runnable_scope_t::ref scope,
+		life_t::ref life,
+		location_t location,
+		bound_var_t::ref value,
+		ast::predicate_t::ref predicate,
+		const column_t &column)
+{
+	/* fetch the member of value that column refers to, by way of the ctors named in predicate */
+	for (auto index : column) {
+		auto ctor_predicate = dyncast<const ast::ctor_predicate_t>(predicate);
+		assert(ctor_predicate != nullptr);
+		value = cast_data_type_to_ctor_struct(builder, scope, location, value, ctor_predicate->token);
+		value = extract_member_by_index(builder, scope, life, location, value, value->type, index,
+				ctor_predicate->params[index]->token.text, false /*as_ref*/);
+		predicate = ctor_predicate->params[index];
+	}
+	return value;
+}
+
+static bool choose_column(
+		runnable_scope_t::ref scope,
+		types::type_t::ref type,
+		const std::vector<pattern_arm_t *> &rows,
+		std::vector<column_t> &known,
+		column_t &chosen)
+{
+	/* pick the next column to switch on for these rows, using the patterns that check_patterns
+	 * computes their coverage with. we can look at the matched value itself, and at the params
+	 * of any ctor we already know. a column is only a candidate if every row refutes it, since
+	 * a row that matches anything there would need testing in every case of the switch. of
+	 * those, the column that splits the rows into the most cases wins, and ties go to the
+	 * shallowest, leftmost column. a column whose type has a single ctor is known for free,
+	 * which opens up its params in turn. */
+	assert(rows.size() != 0);
+	size_t best_case_count = 0;
+	std::vector<column_t> candidates{column_t{}};
+	for (size_t i = 0; i < candidates.size(); ++i) {
+		column_t column = candidates[i];
+		bool is_known = in_vector(column, known);
+		if (!is_known) {
+			std::vector<std::string> ctor_names;
+			bool refuted = true;
+			for (auto row : rows) {
+				auto ctor_pattern = ctor_pattern_at(row->pattern, column);
+				if (ctor_pattern == nullptr) {
+					refuted = false;
+					break;
+				}
+				if (!in_vector(ctor_pattern->cpv.name, ctor_names)) {
+					ctor_names.push_back(ctor_pattern->cpv.name);
+				}
+			}
+			if (!refuted) {
+				continue;
+			}
+
+			types::type_t::ref type_at_column = column_type(scope, type, rows[0]->pattern, column);
+			if (type_at_column == nullptr) {
+				continue;
+			}
+
+			if (has_single_ctor(scope, type_at_column)) {
+				known.push_back(column);
+				is_known = true;
+			} else if (ctor_names.size() > best_case_count) {
+				best_case_count = ctor_names.size();
+				chosen = column;
+			}
+		}
+
+		if (is_known) {
+			/* every row names the same ctor in a known column */
+			auto ctor_pattern = ctor_pattern_at(rows[0]->pattern, column);
+			assert(ctor_pattern != nullptr);
+			for (size_t index = 0; index < ctor_pattern->cpv.args.size(); ++index) {
+				column_t param = column;
+				param.push_back(index);
+				candidates.push_back(param);
+			}
+		}
+	}
+	return best_case_count != 0;
+}
 
 types::type_t::ref build_patterns(
 		llvm::IRBuilder<> &builder,
@@ -38,117 +200,245 @@ types::type_t::ref build_patterns(
 		llvm_generate_dead_return(builder, scope);
 	}
 
-	llvm::BasicBlock *llvm_next_merge = default_block;
 	assert(pattern_blocks.size() != 0);
 
+	std::vector<pattern_arm_t> arms;
+	for (auto pattern_block : pattern_blocks) {
+		pattern_arm_t arm;
+		arm.pattern_block = pattern_block;
+		arm.ctor_predicate = dyncast<const ast::ctor_predicate_t>(pattern_block->predicate);
+		arm.pattern = pattern_block->predicate->get_pattern(pattern_value->type->get_type(), scope);
+		arms.push_back(arm);
+	}
+
 	bool all_patterns_return = true;
-	for (auto pattern_block_iter = pattern_blocks.rbegin(); pattern_block_iter != pattern_blocks.rend(); ++pattern_block_iter) {
-		auto pattern_block = *pattern_block_iter;
-		auto predicate = pattern_block->predicate;
 
-		std::string pattern_name = predicate->repr();
-		llvm::BasicBlock *check_block = llvm::BasicBlock::Create(
-				builder.getContext(),
-				"test." + pattern_name,
-				llvm_function_current);
+	/* emits the block for an arm whose predicate just matched */
+	auto emit_arm_block = [&] (const pattern_arm_t &arm, llvm::BasicBlock *llvm_pattern_block, runnable_scope_t::ref scope_if_match) {
+		auto pattern_block = arm.pattern_block;
+		std::string pattern_name = pattern_block->predicate->repr();
 
 		llvm::IRBuilderBase::InsertPointGuard ipg(builder);
-		builder.SetInsertPoint(check_block);
 
-		/* create a new block for catching the pattern jump */
-		llvm::BasicBlock *llvm_pattern_block = llvm::BasicBlock::Create(
-				builder.getContext(),
-				"matched." + pattern_name,
-				llvm_function_current);
+		/* start emitting code in the block */
+		builder.SetInsertPoint(llvm_pattern_block);
 
-		runnable_scope_t::ref scope_if_match;
-		if (!predicate->resolve_match(
-					builder, scope, life,
-					location,
-					pattern_value,
-					llvm_pattern_block,
-					llvm_next_merge,
-					&scope_if_match))
-		{
-			/* this pattern cannot match because the incoming type is unbound */
-			assert(!builder.GetInsertBlock()->getTerminator());
-			builder.CreateBr(llvm_next_merge);
+		/* set up the variable to be interpreted as the type we've matched */
+		scope_t::ref pattern_scope = (
+				(scope_if_match != nullptr)
+				? scope_if_match
+				: scope->new_runnable_scope(string_format("pattern.%s", pattern_name.c_str())));
 
-			assert(llvm_pattern_block->getTerminator() == nullptr);
-			llvm::IRBuilderBase::InsertPointGuard ipg(builder);
-			builder.SetInsertPoint(llvm_pattern_block);
-			assert(!builder.GetInsertBlock()->getTerminator());
-			builder.CreateBr(llvm_next_merge);
+		bool pattern_returns = false;
+		bound_var_t::ref block_value;
+		if (expected_type != type_bottom()) {
+			block_value = pattern_block->block->resolve_expression(
+					builder, pattern_scope, life, false /*as_ref*/, expected_type);
 
-			llvm_next_merge = check_block;
+			if (block_value == nullptr) {
+				/* block_value probably returned, so it has no value... */
+			} else {
+				/* we are in an expression */
+				unification_t unification = unify(expected_type, block_value->type->get_type(), pattern_scope);
+				if (!unification.result) {
+					auto error = user_error(block_value->get_location(), "value does not have a cohesive type with the rest of the match expression");
+					error.add_info(expected_type->get_location(), "expected type %s", expected_type->str().c_str());
+					throw error;
+				} else {
+					/* update expected type to ensure we are narrowing what is acceptable */
+					expected_type = expected_type->rebind(unification.bindings);
+					assert(expected_type != type_bottom());
+				}
+			}
 		} else {
+			pattern_block->block->resolve_statement(builder, pattern_scope, life, nullptr, &pattern_returns);
+		}
 
-			/* save this as the "next" block to jump to (since we are traversing the patterns in
-			 * reverse order */
-			llvm_next_merge = check_block;
+		// assert_implies(block_value == nullptr, pattern_returns);
+		if (!pattern_returns && builder.GetInsertBlock()->getTerminator() == nullptr) {
+			/* if this block didn't return or break/continue, then we need to make sure we can merge
+			 * to the next block */
+			all_patterns_return = false;
+			assert(builder.GetInsertBlock()->getTerminator() == nullptr);
+			if (expected_type != type_bottom()) {
+				incoming_values.push_back(std::pair<bound_var_t::ref, llvm::BasicBlock*>{block_value, builder.GetInsertBlock()});
+			}
+			assert(!builder.GetInsertBlock()->getTerminator());
+			builder.CreateBr(merge_block);
+		}
+	};
 
-			/* start emitting code in the block */
-			builder.SetInsertPoint(llvm_pattern_block);
+	/* emits a chain of tests of the given arms, in order, starting at llvm_entry_block. the first
+	 * arm that matches wins, and if none do, we fall through to the default block. the ctors in
+	 * the known columns have already been switched on, so the arms only check what is left. */
+	auto emit_chain = [&] (llvm::BasicBlock *llvm_entry_block, const std::vector<pattern_arm_t *> &chain, const std::vector<column_t> &known) {
+		if (chain.size() == 0) {
+			llvm::IRBuilderBase::InsertPointGuard ipg(builder);
+			builder.SetInsertPoint(llvm_entry_block);
+			builder.CreateBr(default_block);
+			return;
+		}
 
-			/* set up the variable to be interpreted as the type we've matched */
-			scope_t::ref pattern_scope = (
-					(scope_if_match != nullptr)
-					? scope_if_match
-					: scope->new_runnable_scope(string_format("pattern.%s", pattern_name.c_str())));
+		llvm::BasicBlock *check_block = llvm_entry_block;
+		for (size_t i = 0; i < chain.size(); ++i) {
+			pattern_arm_t &arm = *chain[i];
+			auto predicate = arm.pattern_block->predicate;
+			std::string pattern_name = predicate->repr();
 
-			bool pattern_returns = false;
-			bound_var_t::ref block_value;
-			if (expected_type != type_bottom()) {
-				block_value = pattern_block->block->resolve_expression(
-						builder, pattern_scope, life, false /*as_ref*/, expected_type);
+			llvm::IRBuilderBase::InsertPointGuard ipg(builder);
+			builder.SetInsertPoint(check_block);
+
+			if (arm.llvm_matched_block != nullptr) {
+				/* this arm was already emitted in another chain. only irrefutable arms are shared
+				 * across chains, so this arm always matches, and nothing after it can run */
+				assert(arm.ctor_predicate == nullptr);
+				builder.CreateBr(arm.llvm_matched_block);
+				return;
+			}
 
-				if (block_value == nullptr) {
-					/* block_value probably returned, so it has no value... */
-				} else {
-					/* we are in an expression */
-					unification_t unification = unify(expected_type, block_value->type->get_type(), pattern_scope);
-					if (!unification.result) {
-						auto error = user_error(block_value->get_location(), "value does not have a cohesive type with the rest of the match expression");
-						error.add_info(expected_type->get_location(), "expected type %s", expected_type->str().c_str());
-						throw error;
-					} else {
-						/* update expected type to ensure we are narrowing what is acceptable */
-						expected_type = expected_type->rebind(unification.bindings);
-						assert(expected_type != type_bottom());
-					}
+			llvm::BasicBlock *llvm_next_block = (i + 1 < chain.size())
+				? llvm::BasicBlock::Create(builder.getContext(), "test." + chain[i + 1]->pattern_block->predicate->repr(), llvm_function_current)
+				: default_block;
+
+			/* create a new block for catching the pattern jump */
+			llvm::BasicBlock *llvm_pattern_block = llvm::BasicBlock::Create(
+					builder.getContext(),
+					"matched." + pattern_name,
+					llvm_function_current);
+
+			std::set<const ast::predicate_t *> known_ctors;
+			for (auto &column : known) {
+				if (ctor_pattern_at(arm.pattern, column) != nullptr) {
+					known_ctors.insert(predicate_at(predicate, column).get());
 				}
+			}
+
+			runnable_scope_t::ref scope_if_match;
+			bool can_match = (arm.ctor_predicate != nullptr && known_ctors.count(predicate.get()) != 0)
+				? arm.ctor_predicate->resolve_match_params(
+						builder, scope, life,
+						location,
+						pattern_value,
+						llvm_pattern_block,
+						llvm_next_block,
+						&scope_if_match,
+						&known_ctors)
+				: predicate->resolve_match(
+						builder, scope, life,
+						location,
+						pattern_value,
+						llvm_pattern_block,
+						llvm_next_block,
+						&scope_if_match);
+
+			if (!can_match) {
+				/* this pattern cannot match because the incoming type is unbound */
+				assert(!builder.GetInsertBlock()->getTerminator());
+				builder.CreateBr(llvm_next_block);
+
+				assert(llvm_pattern_block->getTerminator() == nullptr);
+				builder.SetInsertPoint(llvm_pattern_block);
+				assert(!builder.GetInsertBlock()->getTerminator());
+				builder.CreateBr(llvm_next_block);
+			} else {
+				arm.llvm_matched_block = llvm_pattern_block;
+				emit_arm_block(arm, llvm_pattern_block, scope_if_match);
+			}
+
+			check_block = llvm_next_block;
+		}
+	};
+
+	/* compiles the arms into a decision tree. rather than have every arm fetch and compare the
+	 * same ctor ids in turn, pick a column (see choose_column), fetch its ctor id once and switch
+	 * on it. each case goes on to handle only the arms that name that ctor in the column, in
+	 * their original order, and then the arms that match anything. those catch-all arms are
+	 * shared between all the cases, and also make up the default case. once no column is
+	 * worth switching on, the remaining arms are tested one at a time by emit_chain. */
+	std::function<void (llvm::BasicBlock *, const std::vector<pattern_arm_t *> &, std::vector<column_t>)> emit_tree;
+	emit_tree = [&] (llvm::BasicBlock *llvm_entry_block, const std::vector<pattern_arm_t *> &chain, std::vector<column_t> known) {
+		/* an arm that matches anything cuts the chain short, since nothing after it can run */
+		std::vector<pattern_arm_t *> rows;
+		std::vector<pattern_arm_t *> catch_alls;
+		for (auto arm : chain) {
+			if (catch_alls.size() == 0 && arm->pattern->asAllOf() == nullptr) {
+				rows.push_back(arm);
 			} else {
-				pattern_block->block->resolve_statement(builder, pattern_scope, life, nullptr, &pattern_returns);
+				catch_alls.push_back(arm);
+			}
+		}
+
+		column_t column;
+		bound_var_t::ref column_value;
+		if (rows.size() >= 2 && choose_column(scope, pattern_value->type->get_type(), rows, known, column)) {
+			llvm::IRBuilderBase::InsertPointGuard ipg(builder);
+			builder.SetInsertPoint(llvm_entry_block);
+			try {
+				column_value = extract_column(builder, scope, life, location, pattern_value,
+						rows[0]->pattern_block->predicate, column);
+			} catch (unbound_type_error &error) {
+				/* this column cannot be reached because its type cannot be instantiated */
 			}
+		}
+
+		if (column_value == nullptr) {
+			emit_chain(llvm_entry_block, chain, known);
+			return;
+		}
+
+		llvm::IRBuilderBase::InsertPointGuard ipg(builder);
+		builder.SetInsertPoint(llvm_entry_block);
 
-#if 0
-			if (pattern_returns && builder.GetInsertBlock()->getTerminator() == nullptr) {
-				log(log_info, "we are in %s\n%s",
-					   	builder.GetInsertBlock()->getName().str().c_str(),
-						llvm_print_function(llvm_function_current).c_str());
-				dbg();
+		bound_var_t::ref column_ctor_id = call_get_ctor_id(scope, life, rows[0]->pattern_block,
+				make_iid("column_ctor_id"), builder, column_value);
+
+		std::vector<std::string> ctor_names;
+		for (auto row : rows) {
+			std::string ctor_name = ctor_pattern_at(row->pattern, column)->cpv.name;
+			if (!in_vector(ctor_name, ctor_names)) {
+				ctor_names.push_back(ctor_name);
 			}
-#endif
-			// assert_implies(block_value == nullptr, pattern_returns);
-			if (!pattern_returns && builder.GetInsertBlock()->getTerminator() == nullptr) {
-				/* if this block didn't return or break/continue, then we need to make sure we can merge
-				 * to the next block */
-				all_patterns_return = false;
-				assert(builder.GetInsertBlock()->getTerminator() == nullptr);
-				if (expected_type != type_bottom()) {
-					incoming_values.push_back(std::pair<bound_var_t::ref, llvm::BasicBlock*>{block_value, builder.GetInsertBlock()});
+		}
+
+		llvm::BasicBlock *llvm_switch_default_block = llvm::BasicBlock::Create(
+				builder.getContext(), "pattern.switch.default", llvm_function_current);
+		llvm::SwitchInst *llvm_switch = builder.CreateSwitch(
+				column_ctor_id->get_llvm_value(), llvm_switch_default_block, ctor_names.size());
+
+		std::vector<column_t> known_in_case = known;
+		known_in_case.push_back(column);
+		for (auto &ctor_name : ctor_names) {
+			llvm::BasicBlock *llvm_case_block = llvm::BasicBlock::Create(
+					builder.getContext(), "pattern.case." + ctor_name, llvm_function_current);
+			llvm_switch->addCase(builder.getInt32(atomize(ctor_name)), llvm_case_block);
+
+			std::vector<pattern_arm_t *> case_chain;
+			for (auto row : rows) {
+				if (ctor_pattern_at(row->pattern, column)->cpv.name == ctor_name) {
+					case_chain.push_back(row);
 				}
-				assert(!builder.GetInsertBlock()->getTerminator());
-				builder.CreateBr(merge_block);
 			}
+			case_chain.insert(case_chain.end(), catch_alls.begin(), catch_alls.end());
+			emit_tree(llvm_case_block, case_chain, known_in_case);
 		}
+
+		emit_tree(llvm_switch_default_block, catch_alls, known);
+	};
+
+	llvm::BasicBlock *llvm_dispatch_block = llvm::BasicBlock::Create(
+			builder.getContext(), "pattern.dispatch", llvm_function_current);
+
+	std::vector<pattern_arm_t *> chain;
+	for (auto &arm : arms) {
+		chain.push_back(&arm);
 	}
+	emit_tree(llvm_dispatch_block, chain, {} /*known*/);
 
 	{
 		llvm::IRBuilderBase::InsertPointGuard ipg(builder);
 		builder.SetInsertPoint(llvm_start_block);
 		assert(!builder.GetInsertBlock()->getTerminator());
-		builder.CreateBr(llvm_next_merge);
+		builder.CreateBr(llvm_dispatch_block);
 	}
 
 	if (merge_block != nullptr) {
@@ -404,15 +694,19 @@ bool ast::ctor_predicate_t::resolve_match(
 		llvm::BasicBlock *llvm_no_match_block,
 		runnable_scope_t::ref *scope_if_true) const
 {
-	bound_var_t::ref casted_input;
 	try {
-		casted_input = cast_data_type_to_ctor_struct(
+		cast_data_type_to_ctor_struct(
 				builder, scope, value_location, input_value, token);
 	} catch (unbound_type_error &error) {
 		/* this match is impossible because the type it is matching cannot be instantiated */
 		return false;
 	}
 
+	if (has_single_ctor(scope, input_value->type->get_type())) {
+		return resolve_match_params(builder, scope, life, value_location, input_value,
+				llvm_match_block, llvm_no_match_block, scope_if_true);
+	}
+
 	llvm::Function *llvm_function_current = llvm_get_function(builder);
 	bound_var_t::ref input_ctor_id = call_get_ctor_id(scope, life, shared_from_this(),
 			make_iid("input_ctor_id"), builder, input_value);
@@ -426,6 +720,39 @@ bool ast::ctor_predicate_t::resolve_match(
 			builder.getInt32(ctor_id));
 	match_bit->setName("ctor." + token.text + ".matched");
 
+	llvm::BasicBlock *llvm_params_block = llvm::BasicBlock::Create(
+			builder.getContext(),
+			"ctor." + token.text + ".params",
+			llvm_function_current);
+	builder.CreateCondBr(match_bit, llvm_params_block, llvm_no_match_block);
+
+	/* if this returns false, the caller will terminate the params block */
+	builder.SetInsertPoint(llvm_params_block);
+	return resolve_match_params(builder, scope, life, value_location, input_value,
+			llvm_match_block, llvm_no_match_block, scope_if_true);
+}
+
+bool ast::ctor_predicate_t::resolve_match_params(
+		llvm::IRBuilder<> &builder,
+		runnable_scope_t::ref scope,
+		life_t::ref life,
+		location_t value_location,
+		bound_var_t::ref input_value,
+		llvm::BasicBlock *llvm_match_block,
+		llvm::BasicBlock *llvm_no_match_block,
+		runnable_scope_t::ref *scope_if_true,
+		const std::set<const predicate_t *> *known_ctors) const
+{
+	bound_var_t::ref casted_input;
+	try {
+		casted_input = cast_data_type_to_ctor_struct(
+				builder, scope, value_location, input_value, token);
+	} catch (unbound_type_error &error) {
+		/* this match is impossible because the type it is matching cannot be instantiated */
+		return false;
+	}
+
+	llvm::Function *llvm_function_current = llvm_get_function(builder);
 	llvm::BasicBlock *llvm_next_check = llvm_match_block;
 	runnable_scope_t::ref scope_if_match_at_end = scope;
 
@@ -449,8 +776,16 @@ bool ast::ctor_predicate_t::resolve_match(
 
 		/* resolve sub-patterns */
 		runnable_scope_t::ref scope_if_match = nullptr;
-		if (!params[i]->resolve_match(builder, scope_if_match_at_end, life, 
-				value_location, member, llvm_next_check, llvm_no_match_block, &scope_if_match))
+		auto known_ctor = dyncast<const ctor_predicate_t>(params[i]);
+		if (known_ctor == nullptr || known_ctors == nullptr || known_ctors->count(known_ctor.get()) == 0) {
+			known_ctor = nullptr;
+		}
+		if (!(known_ctor != nullptr
+					? known_ctor->resolve_match_params(builder, scope_if_match_at_end, life,
+						value_location, member, llvm_next_check, llvm_no_match_block, &scope_if_match,
+						known_ctors)
+					: params[i]->resolve_match(builder, scope_if_match_at_end, life, 
+						value_location, member, llvm_next_check, llvm_no_match_block, &scope_if_match)))
 		{
 			assert(!builder.GetInsertBlock()->getTerminator());
 			builder.CreateBr(llvm_no_match_block);
@@ -465,7 +800,7 @@ bool ast::ctor_predicate_t::resolve_match(
 
 	/* by this point llvm_next_check should point to either the next thing we need to check or the
 	 * final pattern block */
-	builder.CreateCondBr(match_bit, llvm_next_check, llvm_no_match_block);
+	builder.CreateBr(llvm_next_check);
 	*scope_if_true = scope_if_match_at_end;
 	return true;
 }
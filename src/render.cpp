@@ -77,6 +77,13 @@ namespace ast {
 		block->render(rs);
 	}
 
+	void for_block_t::render(render_state_t &rs) const {
+		rs.ss << C_CONTROL << K(for) << C_RESET << " " << param_token.text;
+		rs.ss << " " << C_CONTROL << K(in) << C_RESET << " ";
+		iterable->render(rs);
+		block->render(rs);
+	}
+
 	void match_expr_t::render(render_state_t &rs) const {
 		rs.ss << C_CONTROL << K(match) << C_RESET << " ";
 		value->render(rs);
@@ -445,6 +452,9 @@ namespace ast {
 	}
 
 	void function_decl_t::render(render_state_t &rs) const {
+		if (blocking) {
+			rs.ss << '[' << K(blocking) << "] ";
+		}
 		if (extends_module != nullptr) {
 			rs.ss << '[' << K(module) << " " << C_MODULE << extends_module->get_name() << C_RESET << ']';
 			newline(rs);
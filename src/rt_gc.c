@@ -0,0 +1,532 @@
+/* Parallel mark and sweep helpers for the collector in lib/runtime.zion
+ *
+ * The mutator shades the roots with __gc_par_push, then calls __gc_par_mark, which traces the heap
+ * on the mutator plus a pool of helper threads. Each thread owns a mark stack, and threads that run
+ * dry steal half of another thread's stack. Objects whose type uses a mark function cannot be
+ * traced here, since mark functions are compiled zion code that uses the (single threaded) shadow
+ * stack. Those are queued for the mutator to trace with __gc_par_pop_deferred, after which it calls
+ * __gc_par_mark again.
+ *
+ * Sweeping hands out heap regions (see GC_REGION_COUNT in lib/runtime.zion) to the same threads.
+ * Dead objects are unlinked from their region and queued so that the mutator can run their
+ * finalizers and release them with __gc_par_pop_dead.
+ *
+ * Programs built with ZION_GC_STRATEGY=stackmap have no shadow stack. Instead, the compiler emits
+ * a frame table (see src/zion_gc_stackmap.cpp) listing the live roots at every call, and
+ * __gc_visit_stack_map_roots finds them by walking the frame pointer chain up to __main__. Every
+ * frame in between needs a frame pointer. */
+#define _GNU_SOURCE
+#include <sched.h>
+#include "zion_rt.h"
+#include "rt_gc.h"
+
+#define GC_MAX_THREADS 64
+#define GC_STEAL_MAX 256
+
+enum gc_job {
+	gc_job_mark,
+	gc_job_clear,
+	gc_job_sweep,
+};
+
+struct gc_var_stack {
+	pthread_mutex_t lock;
+	struct zion_var **items;
+	int64_t count;
+	int64_t reserved;
+};
+
+static struct {
+	/* the thread pool. thread 0 is always the mutator */
+	pthread_mutex_t lock;
+	pthread_cond_t start_cond;
+	pthread_cond_t done_cond;
+	int64_t thread_count;
+	int64_t epoch;
+	int64_t busy_helpers;
+	enum gc_job job;
+
+	/* marking */
+	struct gc_var_stack mark_stacks[GC_MAX_THREADS];
+	atomic_int_fast64_t active_markers;
+	struct gc_var_stack deferred;
+
+	/* sweeping */
+	struct zion_var **regions;
+	int64_t region_count;
+	uint64_t generation;
+	atomic_int_fast64_t next_region;
+	struct zion_var **dead;
+	int64_t dead_region;
+} gc = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.start_cond = PTHREAD_COND_INITIALIZER,
+	.done_cond = PTHREAD_COND_INITIALIZER,
+	.thread_count = 1,
+};
+
+static void gc_var_stack_init(struct gc_var_stack *stack) {
+	pthread_mutex_init(&stack->lock, NULL);
+	stack->items = NULL;
+	stack->count = 0;
+	stack->reserved = 0;
+}
+
+static void gc_var_stack_push(struct gc_var_stack *stack, struct zion_var *obj) {
+	pthread_mutex_lock(&stack->lock);
+	if (stack->count == stack->reserved) {
+		stack->reserved = stack->reserved < 1024 ? 1024 : stack->reserved * 2;
+		stack->items = realloc(stack->items, sizeof(stack->items[0]) * stack->reserved);
+		if (stack->items == NULL) {
+			perror("out of memory while growing a gc mark stack");
+			exit(1);
+		}
+	}
+	stack->items[stack->count++] = obj;
+	pthread_mutex_unlock(&stack->lock);
+}
+
+static struct zion_var *gc_var_stack_pop(struct gc_var_stack *stack) {
+	struct zion_var *obj = NULL;
+	pthread_mutex_lock(&stack->lock);
+	if (stack->count != 0) {
+		obj = stack->items[--stack->count];
+	}
+	pthread_mutex_unlock(&stack->lock);
+	return obj;
+}
+
+static zion_bool_t gc_try_mark(struct zion_var *obj) {
+	if (obj->type_info->type_kind == type_kind_no_gc) {
+		/* tags live outside of the heap */
+		return 0;
+	}
+	return __atomic_exchange_n(&obj->mark, 1, __ATOMIC_ACQ_REL) == 0;
+}
+
+static void gc_shade(int64_t self, struct zion_var *obj) {
+	if (!gc_try_mark(obj)) {
+		return;
+	}
+
+	switch (obj->type_info->type_kind) {
+	case type_kind_use_offsets:
+		if (((struct zion_type_info_offsets *)obj->type_info)->refs_count != 0) {
+			gc_var_stack_push(&gc.mark_stacks[self], obj);
+		}
+		break;
+	case type_kind_use_mark_fn:
+		gc_var_stack_push(&gc.deferred, obj);
+		break;
+	}
+}
+
+static void gc_scan(int64_t self, struct zion_var *obj) {
+	struct zion_type_info_offsets *type_info = (struct zion_type_info_offsets *)obj->type_info;
+	assert(type_info->head.type_kind == type_kind_use_offsets);
+
+	for (int16_t i = 0; i < type_info->refs_count; ++i) {
+		struct zion_var *child = *(struct zion_var **)((char *)obj + type_info->ref_offsets[i]);
+		if (child != NULL) {
+			gc_shade(self, child);
+		}
+	}
+}
+
+static zion_bool_t gc_steal(int64_t self) {
+	/* take the older half of some other thread's mark stack */
+	struct zion_var *stolen[GC_STEAL_MAX];
+	for (int64_t i = 1; i < gc.thread_count; ++i) {
+		struct gc_var_stack *victim = &gc.mark_stacks[(self + i) % gc.thread_count];
+		int64_t count = 0;
+
+		pthread_mutex_lock(&victim->lock);
+		if (victim->count != 0) {
+			count = (victim->count + 1) / 2;
+			if (count > GC_STEAL_MAX) {
+				count = GC_STEAL_MAX;
+			}
+			memcpy(stolen, victim->items, sizeof(stolen[0]) * count);
+			memmove(victim->items, &victim->items[count],
+					sizeof(victim->items[0]) * (victim->count - count));
+			victim->count -= count;
+		}
+		pthread_mutex_unlock(&victim->lock);
+
+		if (count != 0) {
+			for (int64_t j = 0; j < count; ++j) {
+				gc_var_stack_push(&gc.mark_stacks[self], stolen[j]);
+			}
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static zion_bool_t gc_any_mark_work() {
+	for (int64_t i = 0; i < gc.thread_count; ++i) {
+		if (__atomic_load_n(&gc.mark_stacks[i].count, __ATOMIC_ACQUIRE) != 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void gc_mark_worker(int64_t self) {
+	/* a thread only counts as active while it may still push work. once every thread is idle,
+	 * every mark stack is empty and no more work can appear. */
+	for (;;) {
+		struct zion_var *obj;
+		while ((obj = gc_var_stack_pop(&gc.mark_stacks[self])) != NULL) {
+			gc_scan(self, obj);
+		}
+
+		if (gc_steal(self)) {
+			continue;
+		}
+
+		atomic_fetch_sub(&gc.active_markers, 1);
+		for (;;) {
+			if (atomic_load(&gc.active_markers) == 0) {
+				return;
+			}
+
+			if (gc_any_mark_work()) {
+				atomic_fetch_add(&gc.active_markers, 1);
+				if (gc_steal(self)) {
+					break;
+				}
+				atomic_fetch_sub(&gc.active_markers, 1);
+			}
+			sched_yield();
+		}
+	}
+}
+
+static void gc_clear_worker() {
+	int64_t region;
+	while ((region = atomic_fetch_add(&gc.next_region, 1)) < gc.region_count) {
+		for (struct zion_var *node = gc.regions[region]->next; node != NULL; node = node->next) {
+			node->mark = 0;
+		}
+	}
+}
+
+static void gc_sweep_worker() {
+	int64_t region;
+	while ((region = atomic_fetch_add(&gc.next_region, 1)) < gc.region_count) {
+		struct zion_var *dead = NULL;
+		struct zion_var *node = gc.regions[region]->next;
+		while (node != NULL) {
+			struct zion_var *next = node->next;
+			if (node->mark != 0) {
+				/* survivors go back to being white */
+				node->mark = 0;
+			} else if (node->allocation < gc.generation) {
+				/* unlink it from the region, and chain it onto the dead list */
+				node->prev->next = next;
+				if (next != NULL) {
+					next->prev = node->prev;
+				}
+				node->prev = NULL;
+				node->next = dead;
+				dead = node;
+			}
+			node = next;
+		}
+		gc.dead[region] = dead;
+	}
+}
+
+static void gc_do_job(int64_t self, enum gc_job job) {
+	switch (job) {
+	case gc_job_mark:
+		gc_mark_worker(self);
+		break;
+	case gc_job_clear:
+		gc_clear_worker();
+		break;
+	case gc_job_sweep:
+		gc_sweep_worker();
+		break;
+	}
+}
+
+static void *gc_helper_main(void *arg) {
+	int64_t self = (int64_t)(intptr_t)arg;
+	int64_t seen_epoch = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&gc.lock);
+		while (gc.epoch == seen_epoch) {
+			pthread_cond_wait(&gc.start_cond, &gc.lock);
+		}
+		seen_epoch = gc.epoch;
+		enum gc_job job = gc.job;
+		pthread_mutex_unlock(&gc.lock);
+
+		gc_do_job(self, job);
+
+		pthread_mutex_lock(&gc.lock);
+		if (--gc.busy_helpers == 0) {
+			pthread_cond_signal(&gc.done_cond);
+		}
+		pthread_mutex_unlock(&gc.lock);
+	}
+	return NULL;
+}
+
+static void gc_run_job(enum gc_job job) {
+	/* run job on every thread in the pool, including this one, and wait for them all */
+	pthread_mutex_lock(&gc.lock);
+	gc.job = job;
+	gc.busy_helpers = gc.thread_count - 1;
+	gc.epoch += 1;
+	pthread_cond_broadcast(&gc.start_cond);
+	pthread_mutex_unlock(&gc.lock);
+
+	gc_do_job(0, job);
+
+	pthread_mutex_lock(&gc.lock);
+	while (gc.busy_helpers != 0) {
+		pthread_cond_wait(&gc.done_cond, &gc.lock);
+	}
+	pthread_mutex_unlock(&gc.lock);
+}
+
+zion_int_t __gc_par_init(zion_int_t thread_count) {
+	/* start the helper threads, returning the size of the pool (including the mutator) */
+	if (gc.thread_count > 1 || thread_count <= 1) {
+		return gc.thread_count;
+	}
+
+	if (thread_count > GC_MAX_THREADS) {
+		thread_count = GC_MAX_THREADS;
+	}
+
+	gc_var_stack_init(&gc.deferred);
+	gc_var_stack_init(&gc.mark_stacks[0]);
+	for (int64_t i = 1; i < thread_count; ++i) {
+		gc_var_stack_init(&gc.mark_stacks[i]);
+
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, gc_helper_main, (void *)(intptr_t)i) != 0) {
+			/* make do with the helpers we have so far */
+			break;
+		}
+		pthread_detach(thread);
+
+		/* only grow the pool once the helper exists, so gc_run_job can rely on it */
+		gc.thread_count = i + 1;
+	}
+	return gc.thread_count;
+}
+
+void __gc_par_push(struct zion_var *obj) {
+	/* shade a root. must only be called by the mutator while no job is running */
+	if (obj != NULL) {
+		gc_shade(0, obj);
+	}
+}
+
+void __gc_par_mark() {
+	atomic_store(&gc.active_markers, gc.thread_count);
+	gc_run_job(gc_job_mark);
+}
+
+struct zion_var *__gc_par_pop_deferred() {
+	return gc_var_stack_pop(&gc.deferred);
+}
+
+static void gc_set_regions(struct zion_var **regions, zion_int_t region_count) {
+	gc.regions = regions;
+	gc.region_count = region_count;
+	atomic_store(&gc.next_region, 0);
+}
+
+void __gc_par_clear_marks(struct zion_var **regions, zion_int_t region_count) {
+	gc_set_regions(regions, region_count);
+	gc_run_job(gc_job_clear);
+}
+
+void __gc_par_sweep(struct zion_var **regions, zion_int_t region_count, zion_int_t generation) {
+	gc_set_regions(regions, region_count);
+	gc.generation = generation;
+	gc.dead = realloc(gc.dead, sizeof(gc.dead[0]) * region_count);
+	if (gc.dead == NULL) {
+		perror("out of memory while sweeping");
+		exit(1);
+	}
+	gc.dead_region = 0;
+	gc_run_job(gc_job_sweep);
+}
+
+struct zion_var *__gc_par_pop_dead() {
+	/* hand the mutator the next dead object to finalize and free */
+	while (gc.dead_region < gc.region_count) {
+		struct zion_var *obj = gc.dead[gc.dead_region];
+		if (obj != NULL) {
+			gc.dead[gc.dead_region] = obj->next;
+			obj->next = NULL;
+			return obj;
+		}
+		gc.dead_region += 1;
+	}
+	return NULL;
+}
+
+/* the frame tables emitted for every module by the zion-stackmap gc strategy. these are only
+ * defined when at least one module was compiled with it. */
+extern const char __start_zion_frametable[] __attribute__((weak));
+extern const char __stop_zion_frametable[] __attribute__((weak));
+
+struct gc_frame_descriptor {
+	uintptr_t return_address;
+	uint32_t live_count;
+	int32_t live_offsets[];
+};
+
+static struct {
+	/* an open addressed hash table of descriptors, keyed by return address */
+	pthread_once_t once;
+	const struct gc_frame_descriptor **descriptors;
+	uint64_t mask;
+	uintptr_t stack_top;
+
+	/* the frame of __main__, where every walk has to end up. see __gc_set_stack_base */
+	void **main_fp;
+} stack_map = {
+	.once = PTHREAD_ONCE_INIT,
+};
+
+static const struct gc_frame_descriptor *gc_next_descriptor(const struct gc_frame_descriptor *d) {
+	uintptr_t next = (uintptr_t)&d->live_offsets[d->live_count];
+	return (const struct gc_frame_descriptor *)((next + sizeof(void *) - 1) & ~(sizeof(void *) - 1));
+}
+
+static uint64_t gc_hash_return_address(uintptr_t return_address) {
+	return ((uint64_t)return_address * 0x9e3779b97f4a7c15ull) >> 17;
+}
+
+static void gc_load_stack_map() {
+	uint64_t count = 0;
+	for (const char *table = __start_zion_frametable; table < __stop_zion_frametable;) {
+		uint64_t table_count = *(const uint64_t *)table;
+		const struct gc_frame_descriptor *d = (const struct gc_frame_descriptor *)(table + sizeof(uint64_t));
+		for (uint64_t i = 0; i < table_count; ++i) {
+			d = gc_next_descriptor(d);
+		}
+		count += table_count;
+		table = (const char *)d;
+	}
+
+	/* keep the table at most half full */
+	uint64_t size = 16;
+	while (size < count * 2) {
+		size *= 2;
+	}
+	stack_map.mask = size - 1;
+	stack_map.descriptors = calloc(size, sizeof(stack_map.descriptors[0]));
+	if (stack_map.descriptors == NULL) {
+		perror("out of memory while loading the gc frame table");
+		exit(1);
+	}
+
+	for (const char *table = __start_zion_frametable; table < __stop_zion_frametable;) {
+		uint64_t table_count = *(const uint64_t *)table;
+		const struct gc_frame_descriptor *d = (const struct gc_frame_descriptor *)(table + sizeof(uint64_t));
+		for (uint64_t i = 0; i < table_count; ++i) {
+			uint64_t slot = gc_hash_return_address(d->return_address) & stack_map.mask;
+			while (stack_map.descriptors[slot] != NULL) {
+				slot = (slot + 1) & stack_map.mask;
+			}
+			stack_map.descriptors[slot] = d;
+			d = gc_next_descriptor(d);
+		}
+		table = (const char *)d;
+	}
+
+	/* never walk past the base of the main stack */
+	pthread_attr_t attr;
+	void *stack_addr;
+	size_t stack_size;
+	if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+		if (pthread_attr_getstack(&attr, &stack_addr, &stack_size) == 0) {
+			stack_map.stack_top = (uintptr_t)stack_addr + stack_size;
+		}
+		pthread_attr_destroy(&attr);
+	}
+}
+
+static const struct gc_frame_descriptor *gc_find_descriptor(uintptr_t return_address) {
+	uint64_t slot = gc_hash_return_address(return_address) & stack_map.mask;
+	const struct gc_frame_descriptor *d;
+	while ((d = stack_map.descriptors[slot]) != NULL) {
+		if (d->return_address == return_address) {
+			return d;
+		}
+		slot = (slot + 1) & stack_map.mask;
+	}
+	return NULL;
+}
+
+static void gc_broken_frame_chain(void **fp) {
+	fprintf(stderr, "zion: the frame pointer chain ends at %p, before reaching __main__ at %p. "
+			"some frame on the stack was built without frame pointers, so its callers' gc roots "
+			"can't be found\n", (void *)fp, (void *)stack_map.main_fp);
+	abort();
+}
+
+zion_bool_t __gc_stack_maps_available() {
+	return (uintptr_t)__start_zion_frametable != (uintptr_t)__stop_zion_frametable;
+}
+
+__attribute__((noinline, optimize("no-omit-frame-pointer")))
+void __gc_set_stack_base() {
+	/* __main__ calls this before running any other zion code, so our caller's frame is the
+	 * outermost one that can hold roots */
+	void **fp = __builtin_frame_address(0);
+	stack_map.main_fp = fp[0];
+}
+
+__attribute__((noinline, optimize("no-omit-frame-pointer")))
+void __gc_visit_stack_map_roots(void (*visit)(struct zion_var *)) {
+	/* every frame links to its caller's frame pointer, with the return address just above it. the
+	 * return address tells us which call the caller is stopped at, and therefore which of its
+	 * slots hold live roots. the walk ends at the frame of __main__.
+	 *
+	 * this needs an unbroken frame pointer chain from here to __main__. zion code keeps its frame
+	 * pointers under this strategy (see run_gc_stack_map_setup), and the runtime C is built with
+	 * -fno-omit-frame-pointer. C code that was not, such as a libc qsort calling back into zion,
+	 * breaks the chain, and any roots past it would be missed, so we stop the program instead. */
+	pthread_once(&stack_map.once, gc_load_stack_map);
+
+	void **fp = __builtin_frame_address(0);
+	while (fp != stack_map.main_fp) {
+		if (fp == NULL || ((uintptr_t)fp & (sizeof(void *) - 1)) != 0) {
+			gc_broken_frame_chain(fp);
+		}
+
+		void **caller_fp = fp[0];
+		uintptr_t return_address = (uintptr_t)fp[1];
+
+		if (caller_fp <= fp || (stack_map.stack_top != 0 && (uintptr_t)caller_fp >= stack_map.stack_top)) {
+			if (stack_map.main_fp == NULL) {
+				/* __main__ never ran, so there is no base to hold the walk to */
+				break;
+			}
+			gc_broken_frame_chain(fp);
+		}
+
+		const struct gc_frame_descriptor *d = gc_find_descriptor(return_address);
+		if (d != NULL) {
+			for (uint32_t i = 0; i < d->live_count; ++i) {
+				struct zion_var *root = *(struct zion_var **)((char *)caller_fp + d->live_offsets[i]);
+				if (root != NULL) {
+					visit(root);
+				}
+			}
+		}
+		fp = caller_fp;
+	}
+}
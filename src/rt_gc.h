@@ -0,0 +1,24 @@
+#pragma once
+
+/* these mirror the layouts of var_t, type_info_t and type_info_offsets_t in lib/builtins.zion */
+struct zion_type_info {
+	type_kind_t type_kind;
+	int64_t size;
+	const char *name;
+};
+
+struct zion_var {
+	struct zion_type_info *type_info;
+	int64_t mark;
+	struct zion_var *next;
+	struct zion_var *prev;
+	uint64_t allocation;
+	uint32_t ctor_id;
+};
+
+struct zion_type_info_offsets {
+	struct zion_type_info head;
+	void (*finalize_fn)(struct zion_var *);
+	int16_t refs_count;
+	int16_t *ref_offsets;
+};
@@ -0,0 +1,108 @@
+/* Hash kernels for __hash__ (see lib/hash.zion)
+ *
+ * Byte strings are hashed with wyhash (final version 4, by Wang Yi, released into the public
+ * domain), and scalars are run through its 128-bit multiply-fold mixer. */
+#include "zion_rt.h"
+
+static const uint64_t wyp[4] = {
+	0x2d358dccaa6c78a5ull,
+	0x8bb84b93962eacc9ull,
+	0x4b33a62ed433d4a3ull,
+	0x4d5a2da51de1aa47ull,
+};
+
+static inline void wymum(uint64_t *a, uint64_t *b) {
+	__uint128_t r = *a;
+	r *= *b;
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+}
+
+static inline uint64_t wymix(uint64_t a, uint64_t b) {
+	wymum(&a, &b);
+	return a ^ b;
+}
+
+static inline uint64_t wyr8(const uint8_t *p) {
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
+}
+
+static inline uint64_t wyr4(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static inline uint64_t wyr3(const uint8_t *p, size_t k) {
+	return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+}
+
+static uint64_t wyhash(const void *key, size_t len, uint64_t seed) {
+	const uint8_t *p = (const uint8_t *)key;
+	uint64_t a, b;
+
+	seed ^= wymix(seed ^ wyp[0], wyp[1]);
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+			b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = wyr3(p, len);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+		if (i > 48) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+				see1 = wymix(wyr8(p + 16) ^ wyp[2], wyr8(p + 24) ^ see1);
+				see2 = wymix(wyr8(p + 32) ^ wyp[3], wyr8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = wyr8(p + i - 16);
+		b = wyr8(p + i - 8);
+	}
+
+	a ^= wyp[1];
+	b ^= seed;
+	wymum(&a, &b);
+	return wymix(a ^ wyp[0] ^ len, b ^ wyp[1]);
+}
+
+zion_int_t __hash_bytes(const char *p, zion_int_t len) {
+	return (zion_int_t)wyhash(p, (size_t)len, 0);
+}
+
+zion_int_t __hash_int(zion_int_t x) {
+	return (zion_int_t)wymix((uint64_t)x ^ wyp[0], wyp[1]);
+}
+
+zion_int_t __hash_float(zion_float_t x) {
+	/* values that compare equal must hash equally, so fold -0.0 into 0.0 and every NaN into one */
+	uint64_t bits;
+	if (x == 0) {
+		bits = 0;
+	} else if (x != x) {
+		bits = 0x7ff8000000000000ull;
+	} else {
+		memcpy(&bits, &x, sizeof(bits));
+	}
+	return __hash_int((zion_int_t)bits);
+}
+
+zion_int_t __hash_combine(zion_int_t seed, zion_int_t value) {
+	return (zion_int_t)wymix((uint64_t)seed ^ wyp[2], (uint64_t)value ^ wyp[3]);
+}
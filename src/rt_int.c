@@ -157,3 +157,7 @@ void dbg_se(void *p) {
 	}
 }
 
+
+zion_int_t __int_popcount(zion_int_t x) {
+	return __builtin_popcountll((uint64_t)x);
+}
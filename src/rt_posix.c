@@ -1,6 +1,13 @@
 #include <errno.h>
+#include <time.h>
 #include "zion_rt.h"
 
 zion_int_t __posix_errno() {
 	return errno;
 }
+
+zion_int_t __posix_monotonic_us() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (zion_int_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
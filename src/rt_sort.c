@@ -0,0 +1,122 @@
+/* Radix sort kernels for sort on [int], [uint] and [float] (see lib/sort.zion)
+ *
+ * These are LSD radix sorts over 8-bit digits, sorting the vector's items buffer in place with one
+ * scratch buffer of the same size. All eight digit histograms are counted in a single pass over
+ * the input, and digits on which every key agrees are skipped, so keys in a narrow range (like
+ * timestamps from a single day) only pay for the digits that actually differ.
+ *
+ * Signed and floating point keys are first mapped onto unsigned keys with the same order, and
+ * mapped back once sorted. */
+#include "zion_rt.h"
+
+#define RADIX_DIGITS 8
+#define RADIX_BUCKETS 256
+
+typedef uint64_t (*radix_key_fn)(uint64_t);
+
+static uint64_t radix_identity(uint64_t x) {
+	return x;
+}
+
+static uint64_t radix_flip_sign(uint64_t x) {
+	return x ^ 0x8000000000000000ull;
+}
+
+static uint64_t radix_float_key(uint64_t x) {
+	/* negative floats sort in reverse, so flip all of their bits. positive floats just need to
+	 * sort above the negatives. */
+	return (x & 0x8000000000000000ull) ? ~x : x ^ 0x8000000000000000ull;
+}
+
+static uint64_t radix_float_unkey(uint64_t x) {
+	return (x & 0x8000000000000000ull) ? x ^ 0x8000000000000000ull : ~x;
+}
+
+static void radix_sort_keys(uint64_t *items, uint64_t *scratch, size_t count) {
+	size_t counts[RADIX_DIGITS][RADIX_BUCKETS];
+	memset(counts, 0, sizeof(counts));
+
+	for (size_t i = 0; i < count; ++i) {
+		uint64_t key = items[i];
+		for (uint32_t digit = 0; digit < RADIX_DIGITS; ++digit) {
+			++counts[digit][(key >> (digit * 8)) & 0xff];
+		}
+	}
+
+	uint64_t *from = items;
+	uint64_t *to = scratch;
+	for (uint32_t digit = 0; digit < RADIX_DIGITS; ++digit) {
+		size_t *digit_counts = counts[digit];
+		if (digit_counts[(from[0] >> (digit * 8)) & 0xff] == count) {
+			/* every key has the same value for this digit */
+			continue;
+		}
+
+		size_t offsets[RADIX_BUCKETS];
+		size_t offset = 0;
+		for (uint32_t bucket = 0; bucket < RADIX_BUCKETS; ++bucket) {
+			offsets[bucket] = offset;
+			offset += digit_counts[bucket];
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			uint64_t key = from[i];
+			to[offsets[(key >> (digit * 8)) & 0xff]++] = key;
+		}
+
+		uint64_t *swap = from;
+		from = to;
+		to = swap;
+	}
+
+	if (from != items) {
+		memcpy(items, from, count * sizeof(uint64_t));
+	}
+}
+
+static void radix_sort(uint64_t *items, zion_int_t count, radix_key_fn key, radix_key_fn unkey) {
+	if (count < 2) {
+		return;
+	}
+
+	uint64_t *scratch = (uint64_t *)malloc(count * sizeof(uint64_t));
+	if (scratch == NULL) {
+		fprintf(stderr, "radix sort failed to allocate %lld items\n", (long long)count);
+		exit(-1);
+	}
+
+	if (key != radix_identity) {
+		for (zion_int_t i = 0; i < count; ++i) {
+			items[i] = key(items[i]);
+		}
+	}
+
+	radix_sort_keys(items, scratch, count);
+
+	if (unkey != radix_identity) {
+		for (zion_int_t i = 0; i < count; ++i) {
+			items[i] = unkey(items[i]);
+		}
+	}
+	free(scratch);
+}
+
+void __radix_sort_int(zion_int_t *items, zion_int_t count) {
+	radix_sort((uint64_t *)items, count, radix_flip_sign, radix_flip_sign);
+}
+
+void __radix_sort_uint(uint64_t *items, zion_int_t count) {
+	radix_sort(items, count, radix_identity, radix_identity);
+}
+
+uint64_t __float_order_key(zion_float_t x) {
+	/* the unsigned key radix sorting orders floats by. comparison sorts of short [float]s compare
+	 * these too, so that NaNs and -0.0 land in the same place whichever path a sort takes. */
+	uint64_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	return radix_float_key(bits);
+}
+
+void __radix_sort_float(zion_float_t *items, zion_int_t count) {
+	radix_sort((uint64_t *)items, count, radix_float_key, radix_float_unkey);
+}
@@ -0,0 +1,348 @@
+/* Native threads for zion programs
+ *
+ * Every thread that runs zion code is registered here along with the address of its own
+ * (thread-local) llvm_gc_root_chain, so that the collector can walk every shadow stack.
+ *
+ * Collections are stop-the-world. The collecting thread sets __rt_stop_requested and waits for
+ * every other thread to either park at a safepoint or to be inside a blocking call. The safepoints
+ * are allocation (see create_var in lib/runtime.zion) and the top of every loop, where the
+ * compiler emits an inline poll of __rt_stop_requested (see while_block_t::resolve_statement).
+ * Blocking calls are join, mutex lock, condition waits and the linked functions marked
+ * [blocking], such as posix.read. Threads leaving a blocking call wait for the world to restart
+ * before touching the heap again.
+ *
+ * A thread that spends a long time in C code that is not marked [blocking] still holds up every
+ * collection until it returns. Mark such functions [blocking], as long as they do not touch
+ * managed memory.
+ *
+ * To keep allocation off of the runtime lock, each thread buffers its newly allocated objects and
+ * only hands them over to the shared heap in batches. The collector claims every buffer once the
+ * world is stopped. */
+#include "zion_rt.h"
+#include "rt_gc.h"
+
+#define ALLOCATION_BUFFER_SIZE 256
+
+/* defined by ZionGCLowering */
+extern __thread void *llvm_gc_root_chain;
+
+enum zion_thread_state {
+	zion_thread_running,
+	zion_thread_parked,
+	zion_thread_blocked,
+};
+
+struct zion_thread {
+	struct zion_thread *next;
+	pthread_t pthread;
+	enum zion_thread_state state;
+	void **root_chain;
+
+	/* the start arg stays rooted for the life of the thread */
+	void (*start_fn)(struct zion_var *);
+	struct zion_var *start_arg;
+
+	/* allocations not yet handed over to the shared heap */
+	struct zion_var *buffered;
+	struct zion_var *buffered_tail;
+	int64_t buffered_count;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct zion_thread *registry;
+	int64_t count;
+	atomic_bool threaded;
+	struct zion_thread *collector;
+
+	/* allocations handed over by threads, waiting to be claimed by the collector */
+	struct zion_var *handed_off;
+} threads = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+/* read directly by the loop safepoint polls that the compiler emits */
+_Atomic zion_bool_t __rt_stop_requested = 0;
+
+static struct zion_thread main_thread;
+static __thread struct zion_thread *current_thread;
+
+__attribute__((constructor))
+static void rt_register_main_thread() {
+	main_thread.pthread = pthread_self();
+	main_thread.state = zion_thread_running;
+	main_thread.root_chain = &llvm_gc_root_chain;
+	current_thread = &main_thread;
+	threads.registry = &main_thread;
+	threads.count = 1;
+}
+
+static void rt_park(struct zion_thread *self) {
+	/* wait out someone else's collection. the lock must be held */
+	self->state = zion_thread_parked;
+	pthread_cond_broadcast(&threads.cond);
+	while (atomic_load(&__rt_stop_requested)) {
+		pthread_cond_wait(&threads.cond, &threads.lock);
+	}
+	self->state = zion_thread_running;
+}
+
+static int64_t rt_other_running_threads(struct zion_thread *self) {
+	int64_t running = 0;
+	for (struct zion_thread *thread = threads.registry; thread != NULL; thread = thread->next) {
+		if (thread != self && thread->state == zion_thread_running) {
+			++running;
+		}
+	}
+	return running;
+}
+
+static void rt_hand_off_allocations(struct zion_thread *thread) {
+	/* the lock must be held */
+	if (thread->buffered != NULL) {
+		thread->buffered_tail->next = threads.handed_off;
+		threads.handed_off = thread->buffered;
+		thread->buffered = NULL;
+		thread->buffered_tail = NULL;
+		thread->buffered_count = 0;
+	}
+}
+
+zion_bool_t __rt_is_threaded() {
+	return atomic_load_explicit(&threads.threaded, memory_order_relaxed);
+}
+
+void __rt_safepoint() {
+	if (atomic_load_explicit(&__rt_stop_requested, memory_order_acquire)) {
+		struct zion_thread *self = current_thread;
+		pthread_mutex_lock(&threads.lock);
+		if (threads.collector != self) {
+			rt_park(self);
+		}
+		pthread_mutex_unlock(&threads.lock);
+	}
+}
+
+void __rt_stop_the_world() {
+	struct zion_thread *self = current_thread;
+	pthread_mutex_lock(&threads.lock);
+	while (atomic_load(&__rt_stop_requested)) {
+		/* someone else got here first */
+		rt_park(self);
+	}
+
+	atomic_store(&__rt_stop_requested, 1);
+	threads.collector = self;
+	while (rt_other_running_threads(self) != 0) {
+		pthread_cond_wait(&threads.cond, &threads.lock);
+	}
+	pthread_mutex_unlock(&threads.lock);
+}
+
+void __rt_start_the_world() {
+	pthread_mutex_lock(&threads.lock);
+	threads.collector = NULL;
+	atomic_store(&__rt_stop_requested, 0);
+	pthread_cond_broadcast(&threads.cond);
+	pthread_mutex_unlock(&threads.lock);
+}
+
+void __rt_enter_blocking() {
+	if (!__rt_is_threaded()) {
+		/* until a second thread exists, nobody can be waiting for this one to park */
+		return;
+	}
+
+	struct zion_thread *self = current_thread;
+	pthread_mutex_lock(&threads.lock);
+	self->state = zion_thread_blocked;
+	pthread_cond_broadcast(&threads.cond);
+	pthread_mutex_unlock(&threads.lock);
+}
+
+void __rt_leave_blocking() {
+	struct zion_thread *self = current_thread;
+	if (self->state != zion_thread_blocked) {
+		/* see __rt_enter_blocking */
+		return;
+	}
+
+	pthread_mutex_lock(&threads.lock);
+	while (atomic_load(&__rt_stop_requested) && threads.collector != self) {
+		pthread_cond_wait(&threads.cond, &threads.lock);
+	}
+	self->state = zion_thread_running;
+	pthread_mutex_unlock(&threads.lock);
+}
+
+void __rt_buffer_allocation(struct zion_var *obj) {
+	struct zion_thread *self = current_thread;
+	obj->next = self->buffered;
+	self->buffered = obj;
+	if (self->buffered_tail == NULL) {
+		self->buffered_tail = obj;
+	}
+
+	if (++self->buffered_count == ALLOCATION_BUFFER_SIZE) {
+		pthread_mutex_lock(&threads.lock);
+		rt_hand_off_allocations(self);
+		pthread_mutex_unlock(&threads.lock);
+	}
+}
+
+void __rt_claim_allocation_buffers() {
+	/* only called by the collector once the world is stopped */
+	pthread_mutex_lock(&threads.lock);
+	for (struct zion_thread *thread = threads.registry; thread != NULL; thread = thread->next) {
+		rt_hand_off_allocations(thread);
+	}
+	pthread_mutex_unlock(&threads.lock);
+}
+
+struct zion_var *__rt_pop_claimed_allocation() {
+	struct zion_var *obj = threads.handed_off;
+	if (obj != NULL) {
+		threads.handed_off = obj->next;
+		obj->next = NULL;
+	}
+	return obj;
+}
+
+zion_int_t __rt_thread_count() {
+	return threads.count;
+}
+
+static struct zion_thread *rt_get_thread(zion_int_t index) {
+	struct zion_thread *thread = threads.registry;
+	while (index-- != 0) {
+		thread = thread->next;
+	}
+	return thread;
+}
+
+void *__rt_thread_root_chain(zion_int_t index) {
+	struct zion_thread *thread = rt_get_thread(index);
+	return thread->root_chain != NULL ? *thread->root_chain : NULL;
+}
+
+struct zion_var *__rt_thread_start_arg(zion_int_t index) {
+	return rt_get_thread(index)->start_arg;
+}
+
+static void *rt_thread_main(void *arg) {
+	struct zion_thread *self = arg;
+
+	pthread_mutex_lock(&threads.lock);
+	current_thread = self;
+	self->root_chain = &llvm_gc_root_chain;
+	pthread_mutex_unlock(&threads.lock);
+
+	__rt_safepoint();
+	self->start_fn(self->start_arg);
+
+	/* unregister, leaving our allocations behind for the collector */
+	pthread_mutex_lock(&threads.lock);
+	rt_hand_off_allocations(self);
+	struct zion_thread **link = &threads.registry;
+	while (*link != self) {
+		link = &(*link)->next;
+	}
+	*link = self->next;
+	threads.count -= 1;
+	pthread_cond_broadcast(&threads.cond);
+	pthread_mutex_unlock(&threads.lock);
+	return NULL;
+}
+
+struct zion_thread *__rt_thread_spawn(void (*start_fn)(struct zion_var *), struct zion_var *start_arg) {
+	struct zion_thread *thread = calloc(1, sizeof(struct zion_thread));
+	if (thread == NULL) {
+		perror("out of memory while spawning a thread");
+		exit(1);
+	}
+	thread->start_fn = start_fn;
+	thread->start_arg = start_arg;
+	thread->state = zion_thread_running;
+
+	struct zion_thread *self = current_thread;
+	pthread_mutex_lock(&threads.lock);
+	while (atomic_load(&__rt_stop_requested)) {
+		rt_park(self);
+	}
+	atomic_store(&threads.threaded, 1);
+
+	if (pthread_create(&thread->pthread, NULL, rt_thread_main, thread) != 0) {
+		perror("pthread_create");
+		exit(1);
+	}
+
+	/* register it on its behalf so that no collection can miss its start arg */
+	thread->next = threads.registry;
+	threads.registry = thread;
+	threads.count += 1;
+	pthread_mutex_unlock(&threads.lock);
+	return thread;
+}
+
+void __rt_thread_join(struct zion_thread *thread) {
+	__rt_enter_blocking();
+	pthread_join(thread->pthread, NULL);
+	__rt_leave_blocking();
+	free(thread);
+}
+
+pthread_mutex_t *__rt_mutex_create() {
+	pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
+	if (mutex == NULL) {
+		perror("out of memory while creating a mutex");
+		exit(1);
+	}
+	pthread_mutex_init(mutex, NULL);
+	return mutex;
+}
+
+void __rt_mutex_destroy(pthread_mutex_t *mutex) {
+	pthread_mutex_destroy(mutex);
+	free(mutex);
+}
+
+void __rt_mutex_lock(pthread_mutex_t *mutex) {
+	if (pthread_mutex_trylock(mutex) == 0) {
+		return;
+	}
+
+	__rt_enter_blocking();
+	pthread_mutex_lock(mutex);
+	__rt_leave_blocking();
+}
+
+void __rt_mutex_unlock(pthread_mutex_t *mutex) {
+	pthread_mutex_unlock(mutex);
+}
+
+pthread_cond_t *__rt_cond_create() {
+	pthread_cond_t *cond = malloc(sizeof(pthread_cond_t));
+	if (cond == NULL) {
+		perror("out of memory while creating a condition variable");
+		exit(1);
+	}
+	pthread_cond_init(cond, NULL);
+	return cond;
+}
+
+void __rt_cond_destroy(pthread_cond_t *cond) {
+	pthread_cond_destroy(cond);
+	free(cond);
+}
+
+void __rt_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+	__rt_enter_blocking();
+	pthread_cond_wait(cond, mutex);
+	__rt_leave_blocking();
+}
+
+void __rt_cond_signal(pthread_cond_t *cond) {
+	pthread_cond_signal(cond);
+}
@@ -735,6 +735,14 @@ struct closure_scope_impl_t final : public std::enable_shared_from_this<closure_
 				make_iid_impl("opaque closure", location));
 	}
 
+	std::map<std::string, bound_var_t::ref> get_captured_values() const override {
+		std::map<std::string, bound_var_t::ref> captured_values;
+		for (auto &capture : captures) {
+			captured_values[capture.name] = capture.original_value;
+		}
+		return captured_values;
+	}
+
 	/* the capture builder will emit loads so that they can be copied into the closure. note that it is doing this back
 	 * in the context of the running scope where this closure is being instantiated, so we need this builder in order to
 	 * remember the context of where we were at the time of capture. */
@@ -882,6 +890,14 @@ struct runnable_scope_impl_t : public std::enable_shared_from_this<runnable_scop
 		}
 	}
 
+	const tail_call_target_t *get_tail_call_target() const {
+		if (auto parent_scope = dyncast<const runnable_scope_t>(this->get_parent_scope())) {
+			return parent_scope->get_tail_call_target();
+		} else {
+			return nullptr;
+		}
+	}
+
 private:
 	llvm::BasicBlock *loop_break_bb = nullptr;
 	llvm::BasicBlock *loop_continue_bb = nullptr;
@@ -1634,9 +1650,26 @@ struct function_scope_impl_t final : public runnable_scope_impl_t<function_scope
 		this->return_type_constraint = return_type_constraint;
 	}
 
+	void set_tail_call_target(const tail_call_target_t &tail_call_target) {
+		assert(this->tail_call_target.llvm_function == nullptr);
+		this->tail_call_target = tail_call_target;
+	}
+
+	const tail_call_target_t *get_tail_call_target() const {
+		/* function scopes are where the search stops, so closures never jump into the
+		 * function that encloses them */
+		if (tail_call_target.llvm_function != nullptr) {
+			return &tail_call_target;
+		} else {
+			return nullptr;
+		}
+	}
+
 	/* functions have return type constraints for use during type checking */
 	return_type_constraint_t return_type_constraint;
 
+	tail_call_target_t tail_call_target;
+
 };
 
 function_scope_t::ref create_function_scope(std::string module_name, scope_t::ref parent_scope) {
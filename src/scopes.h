@@ -67,6 +67,15 @@ struct scope_t : public env_t {
 
 typedef bound_type_t::ref return_type_constraint_t;
 
+struct tail_call_target_t {
+	/* self calls in tail position store their arguments into the param slots, and jump back to
+	 * the top of the function rather than calling it again */
+	llvm::Function *llvm_function = nullptr;
+	llvm::BasicBlock *llvm_loop_block = nullptr;
+	std::vector<llvm::Value *> llvm_param_slots;
+	types::type_t::refs param_types;
+};
+
 struct closure_scope_t;
 
 struct runnable_scope_t : public virtual scope_t {
@@ -83,6 +92,9 @@ struct runnable_scope_t : public virtual scope_t {
 
 	virtual llvm::BasicBlock *get_innermost_loop_break() const = 0;
 	virtual llvm::BasicBlock *get_innermost_loop_continue() const = 0;
+
+	/* returns null when self calls in this scope can't be turned into jumps */
+	virtual const tail_call_target_t *get_tail_call_target() const = 0;
 };
 
 struct closure_scope_t : public virtual scope_t {
@@ -91,6 +103,9 @@ struct closure_scope_t : public virtual scope_t {
 
 	virtual void set_capture_env(bound_var_t::ref capture_env) = 0;
 	virtual bound_var_t::ref create_closure(llvm::IRBuilder<> &builder, ptr<life_t> life, location_t location, bound_var_t::ref function) = 0;
+
+	/* the values from the running scope that the closure has captured so far, by name */
+	virtual std::map<std::string, bound_var_t::ref> get_captured_values() const = 0;
 };
 
 struct loop_tracker_t {
@@ -166,6 +181,7 @@ struct function_scope_t : public virtual runnable_scope_t {
 
 	static function_scope_t::ref create(std::string module_name, scope_t::ref parent_scope);
 	virtual void set_return_type_constraint(return_type_constraint_t return_type_constraint) = 0;
+	virtual void set_tail_call_target(const tail_call_target_t &tail_call_target) = 0;
 };
 
 struct generic_substitution_scope_t : public virtual scope_t {
@@ -16,6 +16,7 @@ OP(defer)
 OP(dimension)
 OP(divide_assignment)
 OP(dot_expr)
+OP(for_block)
 OP(function_decl)
 OP(function_defn)
 OP(if_block)
@@ -82,6 +82,7 @@ enum token_kind
 #define K(x) const char * const K_##x = #x
 K(_);
 K(and);
+K(blocking);
 K(__unreachable__);
 K(get);
 K(any);
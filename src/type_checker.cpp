@@ -50,6 +50,17 @@ bound_type_t::ref get_fully_bound_param_info(
 }
 
 
+/* how many expressions were folded down to constants while type checking, by module */
+static std::map<std::string, int> folded_constant_counts;
+
+static void count_folded_constant(scope_t::ref scope) {
+	++folded_constant_counts[scope->get_module_scope()->get_leaf_name()];
+}
+
+const std::map<std::string, int> &get_folded_constant_counts() {
+	return folded_constant_counts;
+}
+
 llvm::Value *resolve_init_var(
 		llvm::IRBuilder<> &builder,
 		scope_t::ref scope,
@@ -65,30 +76,20 @@ llvm::Value *resolve_init_var(
 	/* assumption here is that init_var has already been unified against the declared type.
 	 * if this function returns an AllocaInst then that will imply that the variable should be
 	 * treated as a ref that can be changed. */
-	llvm::AllocaInst *llvm_alloca;
-	if (is_managed) {
-		/* we need stack space, and we have to track it for garbage collection */
-		llvm_alloca = llvm_call_gcroot(llvm_function, value_type, symbol);
-	} else if (obj.is_let()) {
-		/* we don't need a stack var */
-		llvm_alloca = nullptr;
-	} else {
-		/* we need some stack space because this name is mutable */
-		llvm_alloca = llvm_create_entry_block_alloca(llvm_function, value_type, symbol);
-	}
-
 	if (init_var == nullptr) {
 		if (declared_type->eval_predicate(tb_maybe, scope)) {
 			/* this can be null, and we do not allow user-defined __init__ for maybe types, so let's initialize it as null */
 			llvm::Constant *llvm_null_value = llvm::Constant::getNullValue(value_type->get_llvm_specific_type());
-			if (llvm_alloca == nullptr) {
+			if (obj.is_let() && !is_managed) {
 				return llvm_null_value;
 			} else {
 				if (obj.is_let()) {
 					throw user_error(obj.get_location(), "you might as well just use " c_id("null") " rather than declaring this uninitialized maybe");
 				}
 
-				assert(llvm_alloca != nullptr);
+				llvm::AllocaInst *llvm_alloca = is_managed
+					? llvm_call_gcroot(llvm_function, value_type, symbol)
+					: llvm_create_entry_block_alloca(llvm_function, value_type, symbol);
 				builder.CreateStore(llvm_null_value, llvm_alloca);
 				return llvm_alloca;
 			}
@@ -126,25 +127,35 @@ llvm::Value *resolve_init_var(
 		llvm_init_value->setName(string_format("%s.initializer", symbol.c_str()));
 	}
 
-	if (llvm_alloca == nullptr) {
-		/* this is a native 'let' */
-		assert(obj.is_let());
-		assert(!is_managed);
+	if (obj.is_let() && (!is_managed || llvm::isa<llvm::Constant>(llvm_init_value))) {
+		/* this is a native 'let', or a 'let' of a constant (like a str literal). we don't need a
+		 * stack var. constants never live on the heap, so there is nothing for the garbage
+		 * collector to find. this looks at the coerced value, since coercion may box a constant
+		 * into a new heap object. */
 		return llvm_init_value;
+	}
+
+	llvm::AllocaInst *llvm_alloca;
+	if (is_managed) {
+		/* we need stack space, and we have to track it for garbage collection */
+		llvm_alloca = llvm_call_gcroot(llvm_function, value_type, symbol);
 	} else {
-		debug_above(6, log(log_info, "creating a store instruction %s := %s",
-					llvm_print(llvm_alloca).c_str(),
-					llvm_print(llvm_init_value).c_str()));
-
-		builder.CreateStore(llvm_init_value, llvm_alloca);
-		if (obj.is_let()) {
-			/* this is a managed 'let' */
-			assert(is_managed);
-			return builder.CreateLoad(llvm_alloca);
-		} else {
-			/* this is a native or managed 'var' */
-			return llvm_alloca;
-		}
+		/* we need some stack space because this name is mutable */
+		llvm_alloca = llvm_create_entry_block_alloca(llvm_function, value_type, symbol);
+	}
+
+	debug_above(6, log(log_info, "creating a store instruction %s := %s",
+				llvm_print(llvm_alloca).c_str(),
+				llvm_print(llvm_init_value).c_str()));
+
+	builder.CreateStore(llvm_init_value, llvm_alloca);
+	if (obj.is_let()) {
+		/* this is a managed 'let' */
+		assert(is_managed);
+		return builder.CreateLoad(llvm_alloca);
+	} else {
+		/* this is a native or managed 'var' */
+		return llvm_alloca;
 	}
 }
 
@@ -409,17 +420,21 @@ bound_var_t::ref upsert_module_variable(
 					llvm_print(llvm_global_variable).c_str(),
 					llvm_print(init_var->get_llvm_value()).c_str()));
 
-		llvm::Value *llvm_init_value = coerce_value(builder, module_scope, 
-				life, var_decl.get_location(), declared_type, init_var);
+		llvm::Value *llvm_init_value = llvm_maybe_pointer_cast(builder,
+				coerce_value(builder, module_scope, life, var_decl.get_location(), declared_type, init_var),
+				bound_type->get_llvm_specific_type());
 
-		if (llvm_init_value->getName().str().size() == 0) {
-			llvm_init_value->setName(string_format("%s.initializer", symbol.c_str()));
-		}
+		if (auto llvm_constant_init = llvm::dyn_cast<llvm::Constant>(llvm_init_value)) {
+			/* there is nothing to run at startup, the global can just start out with this value */
+			debug_above(6, log(log_info, "statically initializing %s", symbol.c_str()));
+			llvm_global_variable->setInitializer(llvm_constant_init);
+		} else {
+			if (llvm_init_value->getName().str().size() == 0) {
+				llvm_init_value->setName(string_format("%s.initializer", symbol.c_str()));
+			}
 
-		builder.CreateStore(
-				llvm_maybe_pointer_cast(builder, llvm_init_value,
-					bound_type->get_llvm_specific_type()),
-				llvm_global_variable);
+			builder.CreateStore(llvm_init_value, llvm_global_variable);
+		}
 	} else {
 		bool is_managed = false;
 		var_decl_variable->type->is_managed_ptr(
@@ -728,6 +743,42 @@ bound_var_t::ref ast::link_var_statement_t::resolve_expression(
 	return var_decl->resolve_as_link(builder, module_scope);
 }
 
+static llvm::Function *get_or_create_blocking_wrapper(
+		llvm::Module *llvm_module,
+		llvm::Function *llvm_callee)
+{
+	/* a thread that is waiting on the outside world can't reach a safepoint, so it tells the
+	 * runtime that it is blocked for the duration of the call. see __rt_enter_blocking in
+	 * src/rt_thread.c */
+	std::string name = "__blocking." + llvm_callee->getName().str();
+	if (llvm::Function *llvm_wrapper = llvm_module->getFunction(name)) {
+		return llvm_wrapper;
+	}
+
+	llvm::LLVMContext &llvm_context = llvm_module->getContext();
+	llvm::Function *llvm_wrapper = llvm::Function::Create(llvm_callee->getFunctionType(),
+			llvm::Function::InternalLinkage, name, llvm_module);
+	llvm::FunctionType *llvm_void_fn_type = llvm::FunctionType::get(
+			llvm::Type::getVoidTy(llvm_context), false /*isVarArg*/);
+
+	llvm::IRBuilder<> builder(llvm::BasicBlock::Create(llvm_context, "entry", llvm_wrapper));
+	builder.CreateCall(llvm_module->getOrInsertFunction("__rt_enter_blocking", llvm_void_fn_type));
+
+	std::vector<llvm::Value *> llvm_args;
+	for (auto &arg : llvm_wrapper->args()) {
+		llvm_args.push_back(&arg);
+	}
+	llvm::Value *llvm_ret = builder.CreateCall(llvm_callee, llvm_args);
+
+	builder.CreateCall(llvm_module->getOrInsertFunction("__rt_leave_blocking", llvm_void_fn_type));
+	if (llvm_ret->getType()->isVoidTy()) {
+		builder.CreateRetVoid();
+	} else {
+		builder.CreateRet(llvm_ret);
+	}
+	return llvm_wrapper;
+}
+
 bound_var_t::ref ast::link_function_statement_t::resolve_expression(
 		llvm::IRBuilder<> &builder,
 		scope_t::ref scope,
@@ -775,6 +826,10 @@ bound_var_t::ref ast::link_function_statement_t::resolve_expression(
 
 	assert(llvm_print(llvm_value->getType()) != llvm_print(llvm_func_type));
 
+	if (extern_function->blocking) {
+		llvm_value = get_or_create_blocking_wrapper(llvm_module, llvm::cast<llvm::Function>(llvm_value));
+	}
+
 	/* get the full function type */
 	types::type_function_t::ref function_sig = get_function_type(type_constraints, args, return_value);
 	debug_above(3, log(log_info, "%s has type %s",
@@ -955,12 +1010,113 @@ void ast::callsite_expr_t::resolve_statement(
 	resolve_expression(builder, scope, life, false /*as_ref*/, nullptr);
 }
 
+static bool emit_self_tail_call(
+		llvm::IRBuilder<> &builder,
+		scope_t::ref scope,
+		life_t::ref life,
+		bound_var_t::ref function,
+		const bound_var_t::refs &arguments)
+{
+	runnable_scope_t::ref runnable_scope = dyncast<runnable_scope_t>(scope);
+	const tail_call_target_t *tail_call_target = (runnable_scope != nullptr)
+		? runnable_scope->get_tail_call_target()
+		: nullptr;
+
+	if (tail_call_target == nullptr || function->get_llvm_value() != tail_call_target->llvm_function) {
+		return false;
+	}
+
+	assert(arguments.size() == tail_call_target->llvm_param_slots.size());
+
+	/* all of the arguments must be ready before we overwrite any of the params */
+	std::vector<llvm::Value *> llvm_args;
+	for (size_t i = 0; i < arguments.size(); ++i) {
+		llvm_args.push_back(coerce_value(builder, scope, life,
+					arguments[i]->get_location(),
+					tail_call_target->param_types[i],
+					arguments[i]));
+	}
+
+	/* leaving this call of the function, just like a return would */
+	life->release_vars(builder, scope, lf_function);
+
+	for (size_t i = 0; i < llvm_args.size(); ++i) {
+		builder.CreateStore(llvm_args[i], tail_call_target->llvm_param_slots[i]);
+	}
+	builder.CreateBr(tail_call_target->llvm_loop_block);
+	return true;
+}
+
+static bool mark_sibling_tail_call(llvm::IRBuilder<> &builder, llvm::Value *llvm_return_value) {
+	/* a return of a call to another function with the same signature as this one can reuse
+	 * this function's stack frame, so that mutually recursive functions run in constant
+	 * stack space. this must be checked after the vars have been released, since it is only
+	 * legal when nothing but the ret follows the call. */
+	llvm::CallInst *llvm_call_inst = llvm::dyn_cast<llvm::CallInst>(llvm_return_value);
+	if (llvm_call_inst == nullptr || llvm_call_inst->getParent() != builder.GetInsertBlock()) {
+		return false;
+	}
+
+	llvm::Function *llvm_caller = builder.GetInsertBlock()->getParent();
+	llvm::Function *llvm_callee = llvm_call_inst->getCalledFunction();
+	if (llvm_callee == nullptr
+			|| llvm_callee->isVarArg()
+			|| llvm_callee->getFunctionType() != llvm_caller->getFunctionType()
+			|| llvm_callee->getCallingConv() != llvm_caller->getCallingConv())
+	{
+		return false;
+	}
+
+	for (auto &llvm_arg : llvm_call_inst->arg_operands()) {
+		/* the callee can't be handed anything that lives in the frame we are giving up */
+		if (llvm::isa<llvm::AllocaInst>(llvm_arg->stripInBoundsOffsets())) {
+			return false;
+		}
+	}
+
+	/* releasing the vars only nulled out this frame's gc roots, and those stores are dead once
+	 * the frame is gone. anything else after the call means it is not in tail position. */
+	std::vector<llvm::Instruction *> dead_stores;
+	for (auto iter = std::next(llvm_call_inst->getIterator()); iter != builder.GetInsertPoint(); ++iter) {
+		llvm::StoreInst *llvm_store = llvm::dyn_cast<llvm::StoreInst>(&*iter);
+		if (llvm_store == nullptr
+				|| !llvm::isa<llvm::AllocaInst>(llvm_store->getPointerOperand()->stripInBoundsOffsets()))
+		{
+			return false;
+		}
+		dead_stores.push_back(llvm_store);
+	}
+
+	for (auto llvm_store : dead_stores) {
+		llvm_store->eraseFromParent();
+	}
+
+	debug_above(5, log("marking the call to %s from %s as a tail call",
+				llvm_callee->getName().str().c_str(),
+				llvm_caller->getName().str().c_str()));
+
+	/* ZionGCLowering pops this frame's shadow stack entry before the call, rather than at the
+	 * ret, so that the callee pushes its entry in our place */
+	llvm_call_inst->setTailCallKind(llvm::CallInst::TCK_MustTail);
+	return true;
+}
+
 bound_var_t::ref ast::callsite_expr_t::resolve_expression(
 		llvm::IRBuilder<> &builder,
 		scope_t::ref scope,
 		life_t::ref life,
 		bool as_ref,
 		types::type_t::ref expected_type) const
+{
+	return resolve_call(builder, scope, life, expected_type, false /*in_tail_position*/);
+}
+
+bound_var_t::ref ast::callsite_expr_t::resolve_call(
+		llvm::IRBuilder<> &builder,
+		scope_t::ref scope,
+		life_t::ref life,
+		types::type_t::ref expected_type,
+		bool in_tail_position) const
 {
 	try {
 		indent_logger indent(get_location(), 5,
@@ -1054,6 +1210,11 @@ bound_var_t::ref ast::callsite_expr_t::resolve_expression(
 
 			debug_above(5, log(log_info, "function chosen is %s", function->str().c_str()));
 
+			if (in_tail_position && emit_self_tail_call(builder, scope, life, function, arguments)) {
+				/* there is no value, we jumped back to the top of the function */
+				return nullptr;
+			}
+
 			return make_call_value(builder, get_location(), scope, life, function, arguments);
 		} else {
 			bound_var_t::ref lhs_value = function_expr->resolve_expression(builder, scope, life, false /*as_ref*/,
@@ -1477,6 +1638,20 @@ bound_var_t::ref extract_member_by_index(
 				struct_type->str().c_str(), (int)struct_type->dimensions.size());
 	}
 
+	auto member_type = struct_type->dimensions[index];
+	if (types::is_value_tuple(bound_obj_type->get_type(), scope)) {
+		/* unboxed tuples are immutable values, so just pull the member out */
+		llvm::Value *llvm_item = builder.CreateExtractValue(
+				bound_var->resolve_bound_var_value(scope, builder), {(unsigned)index});
+		llvm_item->setName(string_format(".%s", member_name.c_str()));
+
+		auto dot_name = string_format("%s.%s", bound_var->name.c_str(), member_name.c_str());
+		return bound_var_t::create(
+				INTERNAL_LOC(), dot_name,
+				upsert_bound_type(builder, scope, types::without_ref(member_type)),
+				llvm_item, make_iid_impl(dot_name, location));
+	}
+
 	/* get an GEP-able version of the object */
 	llvm::Value *llvm_var_value = llvm_maybe_pointer_cast(builder,
 			bound_var->resolve_bound_var_value(scope, builder),
@@ -1494,7 +1669,6 @@ bound_var_t::ref extract_member_by_index(
 	}
 
 	/* check whether this member_type is allowed to be returned as a ref or not */
-	auto member_type = struct_type->dimensions[index];
 	llvm::Value *llvm_item = (
 			(as_ref && member_type->eval_predicate(tb_ref, scope))
 			? llvm_gep
@@ -1522,7 +1696,8 @@ int64_t parse_int_value(token_t token) {
 		{
 			int64_t value;
 			if (token.text.size() > 2 && token.text.substr(0, 2) == "0x") {
-				value = strtoll(token.text.substr(2).c_str(), nullptr, 16);
+				/* allow hex literals to spell out all 64 bits, as hash constants do */
+				value = (int64_t)strtoull(token.text.substr(2).c_str(), nullptr, 16);
 			} else {
 				value = atoll(token.text.c_str());
 			}
@@ -1538,6 +1713,53 @@ int get_constant_int(ast::item_t::ref item) {
 	return parse_int_value(item->token);
 }
 
+bound_var_t::ref resolve_module_variable_reference(
+		llvm::IRBuilder<> &builder,
+		scope_t::ref scope,
+		location_t location,
+		std::string module_name,
+		std::string symbol,
+		bool as_ref);
+
+void emit_gc_write_barrier(
+		llvm::IRBuilder<> &builder,
+		scope_t::ref scope,
+		life_t::ref life,
+		location_t location,
+		llvm::Value *llvm_value)
+{
+	/* let an in-progress incremental mark know that llvm_value is now reachable from
+	 * somewhere it may have already scanned. see runtime.__gc_write_barrier__. there is
+	 * nothing to do outside of a mark, which is nearly always, so the phase is checked
+	 * inline and only a mark pays for the call. */
+	llvm::Function *llvm_function_current = llvm_get_function(builder);
+	bound_var_t::ref gc_phase = resolve_module_variable_reference(builder, scope, location,
+			"runtime", "_gc_phase", false /*as_ref*/);
+	bound_var_t::ref gc_phase_mark = resolve_module_variable_reference(builder, scope, location,
+			"runtime", "GC_PHASE_MARK", false /*as_ref*/);
+	llvm::Value *llvm_gc_phase = gc_phase->get_llvm_value();
+
+	llvm::BasicBlock *barrier_bb = llvm::BasicBlock::Create(builder.getContext(), "write_barrier", llvm_function_current);
+	llvm::BasicBlock *barrier_done_bb = llvm::BasicBlock::Create(builder.getContext(), "write_barrier.done", llvm_function_current);
+	builder.CreateCondBr(
+			builder.CreateICmpEQ(llvm_gc_phase, gc_phase_mark->get_llvm_value()),
+			barrier_bb, barrier_done_bb);
+
+	builder.SetInsertPoint(barrier_bb);
+	bound_type_t::ref bound_var_ptr_type = upsert_bound_type(builder, scope,
+			type_maybe(type_ptr(type_id(make_iid(STD_MANAGED_TYPE))), {}));
+
+	llvm::Value *llvm_var_ptr = builder.CreatePointerCast(llvm_value,
+			bound_var_ptr_type->get_llvm_type());
+
+	call_program_function(builder, scope, life, "runtime.__gc_write_barrier__", location,
+			{bound_var_t::create(INTERNAL_LOC(), "write_barrier.value", bound_var_ptr_type,
+					llvm_var_ptr, make_iid_impl("write_barrier.value", location))});
+	builder.CreateBr(barrier_done_bb);
+
+	builder.SetInsertPoint(barrier_done_bb);
+}
+
 bound_var_t::ref type_check_assignment(
 		llvm::IRBuilder<> &builder,
 		scope_t::ref scope,
@@ -1579,6 +1801,14 @@ bound_var_t::ref type_check_assignment(
 
 		builder.CreateStore(llvm_rhs_value, lhs_var->get_llvm_value());
 
+		if (!llvm::isa<llvm::AllocaInst>(lhs_var->get_llvm_value())
+				&& !llvm::isa<llvm::Constant>(llvm_rhs_value)
+				&& types::is_managed_ptr(lhs_unreferenced_type, scope)) {
+			/* stack slots are rescanned when marking terminates, and constants (null, tags)
+			 * never live on the heap, so only these stores need the write barrier */
+			emit_gc_write_barrier(builder, scope, life, location, llvm_rhs_value);
+		}
+
 		return lhs_var;
 	} else {
 		throw user_error(location, "left-hand side is incompatible with the right-hand side (%s)",
@@ -2303,13 +2533,18 @@ bound_var_t::ref type_check_binary_operator(
 			!rhs_type->eval_predicate(tb_bool, scope))
 	{
 		/* we are dealing with two integers, standard function resolution rules do not apply */
-		return type_check_binary_integer_op(
+		bound_var_t::ref value = type_check_binary_integer_op(
 				builder, scope, life,
 				obj->get_location(),
 				lhs,
 				rhs,
 				function_name,
 				expected_type);
+		if (llvm::isa<llvm::Constant>(value->get_llvm_value())) {
+			/* the builder folds integer ops on constants as it emits them */
+			count_folded_constant(scope);
+		}
+		return value;
 	} else {
 		/* intercept binary operations on native pointers */
 		if (
@@ -2339,6 +2574,18 @@ bound_var_t::ref type_check_binary_operator(
 			}
 		}
 
+		std::string lhs_str, rhs_str;
+		if (function_name == "__plus__"
+				&& llvm_get_global_str_value(lhs->get_llvm_value(), lhs_str)
+				&& llvm_get_global_str_value(rhs->get_llvm_value(), rhs_str))
+		{
+			/* both sides are str constants, so rather than allocate their concatenation at
+			 * runtime, make it another str constant */
+			debug_above(5, log("folding \"%s\" + \"%s\"", lhs_str.c_str(), rhs_str.c_str()));
+			count_folded_constant(scope);
+			return create_global_str(builder, scope, obj->get_location(), lhs_str + rhs_str);
+		}
+
 		/* get or instantiate a function we can call on these arguments */
 		auto value = call_module_function(
 				builder, scope, life, function_name,
@@ -2485,6 +2732,18 @@ bound_var_t::ref ast::tuple_expr_t::resolve_expression(
 	/* let's get the type for this tuple wrapped as an object */
 	types::type_tuple_t::ref tuple_type = get_tuple_type(args);
 
+	if (types::is_value_tuple(tuple_type, scope)) {
+		/* build unboxed tuples in registers, rather than calling a ctor that allocates */
+		bound_type_t::ref bound_tuple_type = upsert_bound_type(builder, scope, tuple_type);
+		llvm::Value *llvm_tuple = llvm::UndefValue::get(bound_tuple_type->get_llvm_specific_type());
+		for (unsigned index = 0; index < vars.size(); ++index) {
+			llvm_tuple = builder.CreateInsertValue(llvm_tuple,
+					vars[index]->resolve_bound_var_value(scope, builder), {index});
+		}
+		return bound_var_t::create(INTERNAL_LOC(), tuple_type->repr(), bound_tuple_type,
+				llvm_tuple, make_iid_impl(tuple_type->repr(), get_location()));
+	}
+
 	/* now, let's see if we already have a ctor for this tuple type, if not
 	 * we'll need to create a data ctor for this unnamed tuple type */
 	auto program_scope = scope->get_program_scope();
@@ -2518,6 +2777,15 @@ const char *rctstr(rct_t rct) {
 }
 
 
+static void assert_nullable_path(location_t location, types::type_t::ref path_type, scope_t::ref scope) {
+	if (types::is_value_tuple(path_type, scope)) {
+		/* tuples of plain values are structs, not pointers, so there is no null to mix them with */
+		throw user_error(location, "%s is passed by value and cannot be null. use Just(...) and Nothing instead",
+				path_type->str().c_str());
+	}
+	assert(types::is_managed_ptr(path_type, scope));
+}
+
 bound_type_t::ref refine_conditional_type(
 		llvm::IRBuilder<> &builder,
 		scope_t::ref scope,
@@ -2568,10 +2836,10 @@ bound_type_t::ref refine_conditional_type(
 	} else if (unifies(falsey_path_type, truthy_path_type, scope)) {
 		ternary_sum_type = falsey_path_type;
 	} else if (truthy_path_type->eval_predicate(tb_null, scope)) {
-		assert(types::is_managed_ptr(falsey_path_type, scope));
+		assert_nullable_path(location, falsey_path_type, scope);
 		ternary_sum_type = type_maybe(falsey_path_type, scope);
 	} else if (falsey_path_type->eval_predicate(tb_null, scope)) {
-		assert(types::is_managed_ptr(truthy_path_type, scope));
+		assert_nullable_path(location, truthy_path_type, scope);
 		ternary_sum_type = type_maybe(truthy_path_type, scope);
 	} else {
 		auto error = user_error(location, "ternary type is inconsistent");
@@ -3266,6 +3534,57 @@ void type_check_module_links(
 	}
 }
 
+/* the code a module's vars add to __init_module_vars is bracketed by calls into the runtime that
+ * report how long it took, when ZION_STARTUP_TRACE is set. modules whose vars were all statically
+ * initialized add no code, so they are not traced either. */
+static bound_var_t::ref emit_startup_trace_begin(
+		llvm::IRBuilder<> &builder,
+		function_scope_t::ref function_scope,
+		life_t::ref life,
+		std::string module_name)
+{
+	llvm::IRBuilderBase::InsertPointGuard ipg(builder);
+	function_scope->get_program_scope()->set_insert_point_to_init_module_vars_function(builder, module_name);
+
+	bound_var_t::ref begin_fn = get_callable(builder, function_scope,
+			"runtime.__startup_trace_begin", INTERNAL_LOC(),
+			type_args({}), type_variable(INTERNAL_LOC()));
+	return create_callsite(builder, function_scope, life, begin_fn,
+			"startup_trace.start", INTERNAL_LOC(), {});
+}
+
+static void emit_startup_trace_end(
+		llvm::IRBuilder<> &builder,
+		function_scope_t::ref function_scope,
+		life_t::ref life,
+		std::string module_name,
+		bound_var_t::ref start)
+{
+	llvm::Instruction *llvm_begin_call = llvm::dyn_cast<llvm::Instruction>(start->get_llvm_value());
+	assert(llvm_begin_call != nullptr);
+	if (llvm_begin_call->getNextNode() == llvm_begin_call->getParent()->getTerminator()) {
+		/* every var in this module had a constant initializer */
+		llvm_begin_call->eraseFromParent();
+		return;
+	}
+
+	llvm::IRBuilderBase::InsertPointGuard ipg(builder);
+	function_scope->get_program_scope()->set_insert_point_to_init_module_vars_function(builder, module_name);
+
+	bound_type_t::ref mbs_type = upsert_bound_type(builder, function_scope, type_ptr(type_id(make_iid(CHAR_TYPE))));
+	bound_var_t::ref name_arg = bound_var_t::create(INTERNAL_LOC(), "module_name", mbs_type,
+			llvm_create_global_string_constant(builder, *function_scope->get_llvm_module(), module_name),
+			make_iid("module_name"));
+
+	bound_var_t::ref end_fn = get_callable(builder, function_scope,
+			"runtime.__startup_trace_end", INTERNAL_LOC(),
+			type_args({name_arg->type->get_type(), start->type->get_type()}),
+			type_variable(INTERNAL_LOC()));
+	create_callsite(builder, function_scope, life, end_fn,
+			"", INTERNAL_LOC(), {name_arg, start});
+	life->release_vars(builder, function_scope, lf_function);
+}
+
 void type_check_module_vars(
         compiler_t &compiler,
 		llvm::IRBuilder<> &builder,
@@ -3278,6 +3597,18 @@ void type_check_module_vars(
 
 	/* get module level scope variable */
 	module_scope_t::ref module_scope = compiler.get_module_scope(obj.module_key);
+	if (obj.var_decls.size() == 0) {
+		return;
+	}
+
+	function_scope_t::ref trace_scope = module_scope->new_function_scope(
+			std::string("__init_module_vars_") + obj.module_key);
+	auto trace_life = (
+			make_ptr<life_t>(lf_function)
+			->new_life(lf_block)
+			->new_life(lf_statement));
+	bound_var_t::ref trace_start = emit_startup_trace_begin(builder, trace_scope, trace_life, obj.module_key);
+
 	for (auto &var_decl : obj.var_decls) {
 		try {
 			INDENT(3, string_format("resolving module var " c_id("%s") " in " c_module("%s"),
@@ -3300,6 +3631,8 @@ void type_check_module_vars(
 			panic("uncaught exception");
 		}
 	}
+
+	emit_startup_trace_end(builder, trace_scope, trace_life, obj.module_key, trace_start);
 }
 
 void resolve_unchecked_type(
@@ -3460,10 +3793,19 @@ void type_check_program_variables(
 	}
 }
 
+/* module vars are visited by the gc one module at a time, in the order their initializers
+ * run in __init_module_vars */
+struct module_var_range_t {
+	std::string module_key;
+	size_t first_var;
+};
+
 void create_visit_module_vars_function(
 	   	llvm::IRBuilder<> &builder,
 	   	program_scope_t::ref program_scope,
-		std::vector<bound_var_t::ref> global_vars)
+		std::vector<bound_var_t::ref> global_vars,
+		const std::vector<module_var_range_t> &module_var_ranges,
+		llvm::GlobalVariable *llvm_initialized_modules)
 {
 	/* build the global __init_module_vars function */
 	llvm::IRBuilderBase::InsertPointGuard ipg(builder);
@@ -3502,12 +3844,38 @@ void create_visit_module_vars_function(
 
 	auto bound_var_ptr_type = program_scope->get_runtime_type(builder, STD_MANAGED_TYPE, true /*get_ptr*/);
 
-	for (auto global_var : global_vars) {
-		/* for each managed global_var, call the visitor function on it */
-		bool is_managed;
-		global_var->type->is_managed_ptr(builder, program_scope, is_managed);
+	for (size_t i = 0; i < module_var_ranges.size(); ++i) {
+		size_t end_var = (i + 1 < module_var_ranges.size())
+			? module_var_ranges[i + 1].first_var
+			: global_vars.size();
+
+		std::vector<bound_var_t::ref> managed_vars;
+		for (size_t j = module_var_ranges[i].first_var; j < end_var; ++j) {
+			bool is_managed;
+			global_vars[j]->type->is_managed_ptr(builder, program_scope, is_managed);
+			if (is_managed) {
+				managed_vars.push_back(global_vars[j]);
+			}
+		}
 
-		if (is_managed) {
+		if (managed_vars.size() == 0) {
+			continue;
+		}
+
+		/* a collection can happen while __init_module_vars is still running. the vars of modules
+		 * it has not reached yet hold nothing, so there is no need to visit them. */
+		std::string module_key = module_var_ranges[i].module_key;
+		llvm::BasicBlock *llvm_visit_block = llvm::BasicBlock::Create(builder.getContext(),
+				"visit." + module_key, llvm_function);
+		llvm::BasicBlock *llvm_next_block = llvm::BasicBlock::Create(builder.getContext(),
+				"visit." + module_key + ".done", llvm_function);
+		builder.CreateCondBr(
+				builder.CreateICmpUGT(builder.CreateLoad(llvm_initialized_modules), builder.getInt64(i)),
+				llvm_visit_block, llvm_next_block);
+		builder.SetInsertPoint(llvm_visit_block);
+
+		for (auto global_var : managed_vars) {
+			/* for each managed global_var, call the visitor function on it */
 			llvm_create_call_inst(
 					builder,
 					INTERNAL_LOC(),
@@ -3518,6 +3886,9 @@ void create_visit_module_vars_function(
 							global_var->resolve_bound_var_value(program_scope, builder),
 							bound_var_ptr_type->get_llvm_type())});
 		}
+
+		builder.CreateBr(llvm_next_block);
+		builder.SetInsertPoint(llvm_next_block);
 	}
 
 	/* we're done with __visit_module_vars, let's make sure to return */
@@ -3533,12 +3904,31 @@ void type_check_all_module_var_slots(
 		program_scope_t::ref program_scope)
 {
 	std::vector<bound_var_t::ref> global_vars;
+	std::vector<module_var_range_t> module_var_ranges;
+
+	/* __init_module_vars counts the modules whose initializers have finished */
+	llvm::GlobalVariable *llvm_initialized_modules;
+	{
+		llvm::IRBuilderBase::InsertPointGuard ipg(builder);
+		program_scope->set_insert_point_to_init_module_vars_function(builder, "");
+		llvm_initialized_modules = llvm_get_global(llvm_get_module(builder),
+				"__initialized_modules", builder.getInt64(0), false /*is_constant*/);
+	}
+
+	auto check_module_vars = [&](const ast::module_t &module) {
+		module_var_ranges.push_back({module.module_key, global_vars.size()});
+		type_check_module_vars(compiler, builder, module, program_scope,
+				global_vars);
+
+		llvm::IRBuilderBase::InsertPointGuard ipg(builder);
+		program_scope->set_insert_point_to_init_module_vars_function(builder, module.module_key);
+		builder.CreateStore(builder.getInt64(module_var_ranges.size()), llvm_initialized_modules);
+	};
 
 	for (auto &module : obj.modules) {
 		if (module->module_key == "runtime") {
 			assert(!module->global);
-			type_check_module_vars(compiler, builder, *module, program_scope,
-					global_vars);
+			check_module_vars(*module);
 			break;
 		}
 	}
@@ -3551,12 +3941,12 @@ void type_check_all_module_var_slots(
 		// }
 
 		if (module->module_key != "runtime") {
-			type_check_module_vars(compiler, builder, *module, program_scope,
-					global_vars);
+			check_module_vars(*module);
 		}
 	}
 
-	create_visit_module_vars_function(builder, program_scope, global_vars);
+	create_visit_module_vars_function(builder, program_scope, global_vars,
+			module_var_ranges, llvm_initialized_modules);
 }
 
 void type_check_program(
@@ -3801,7 +4191,21 @@ void ast::return_statement_t::resolve_statement(
 
 	auto return_type_constraint = runnable_scope->get_return_type_constraint();
 
-	if (expr != nullptr) {
+	if (auto callsite = dyncast<const ast::callsite_expr_t>(expr)) {
+		if (return_type_constraint != nullptr && !return_type_constraint->is_ref(scope)) {
+			/* returning the result of a call to this same function becomes a loop */
+			return_value = callsite->resolve_call(builder, scope, life,
+					return_type_constraint->get_type(), true /*in_tail_position*/);
+			if (return_value == nullptr) {
+				return;
+			}
+		}
+	}
+
+	if (return_value != nullptr) {
+		/* this was a regular call after all */
+		return_type = return_value->type;
+	} else if (expr != nullptr) {
 		/* if there is a return expression resolve it into a value. also, be
 		 * sure to retain whether the function signature necessitates a ref type */
 		return_value = expr->resolve_expression(builder, scope, life,
@@ -3843,6 +4247,10 @@ void ast::return_statement_t::resolve_statement(
 			/* release all variables from all lives */
 			life->release_vars(builder, scope, lf_function);
 
+			if (dyncast<const ast::callsite_expr_t>(expr)) {
+				mark_sibling_tail_call(builder, llvm_return_value);
+			}
+
 			builder.CreateRet(llvm_return_value);
 			return;
 		}
@@ -4082,6 +4490,31 @@ bound_var_t::ref ast::expression_t::resolve_condition(
 			expected_type);
 }
 
+static void emit_safepoint_poll(llvm::IRBuilder<> &builder) {
+	/* a loop that never allocates would otherwise never park for another thread's collection.
+	 * the flag is only set while a collection is waiting, so the slow path is out of line. see
+	 * src/rt_thread.c */
+	llvm::Module *llvm_module = llvm_get_module(builder);
+	llvm::Function *llvm_function_current = llvm_get_function(builder);
+	llvm::Value *llvm_stop_requested = llvm_module->getOrInsertGlobal("__rt_stop_requested",
+			builder.getInt64Ty());
+
+	llvm::LoadInst *llvm_flag = builder.CreateLoad(llvm_stop_requested, "stop_requested");
+	llvm_flag->setAtomic(llvm::AtomicOrdering::Monotonic);
+	llvm_flag->setAlignment(8);
+
+	llvm::BasicBlock *safepoint_bb = llvm::BasicBlock::Create(builder.getContext(), "safepoint", llvm_function_current);
+	llvm::BasicBlock *polled_bb = llvm::BasicBlock::Create(builder.getContext(), "safepoint.done", llvm_function_current);
+	builder.CreateCondBr(builder.CreateICmpNE(llvm_flag, builder.getInt64(0)), safepoint_bb, polled_bb);
+
+	builder.SetInsertPoint(safepoint_bb);
+	builder.CreateCall(llvm_module->getOrInsertFunction("__rt_safepoint",
+				llvm::FunctionType::get(builder.getVoidTy(), false /*isVarArg*/)));
+	builder.CreateBr(polled_bb);
+
+	builder.SetInsertPoint(polled_bb);
+}
+
 void ast::while_block_t::resolve_statement(
 		llvm::IRBuilder<> &builder,
 		scope_t::ref scope,
@@ -4102,6 +4535,9 @@ void ast::while_block_t::resolve_statement(
 	builder.CreateBr(while_cond_bb);
 	builder.SetInsertPoint(while_cond_bb);
 
+	/* every trip around the loop, including continues, comes back through here */
+	emit_safepoint_poll(builder);
+
 	/* demarcate a loop boundary here */
 	life = life->new_life(lf_loop|lf_block);
 
@@ -4159,6 +4595,57 @@ void ast::while_block_t::resolve_statement(
 	builder.SetInsertPoint(while_end_bb);
 }
 
+void ast::for_block_t::resolve_statement(
+		llvm::IRBuilder<> &builder,
+		scope_t::ref scope,
+		life_t::ref life,
+		runnable_scope_t::ref *,
+		bool *returns) const
+{
+	assert(token.text == "for");
+
+	/* the hidden iterable variable lives until the loop is done */
+	life = life->new_life(lf_block);
+
+	runnable_scope_t::ref iterable_scope;
+	{
+		auto stmt_life = life->new_life(lf_statement);
+		iterable_decl->resolve_statement(builder, scope, stmt_life, &iterable_scope, nullptr);
+		stmt_life->release_vars(builder, scope, lf_statement);
+	}
+	assert(iterable_scope != nullptr);
+
+	bound_var_t::ref iterable_var = iterable_scope->get_bound_variable(builder,
+			iterable_decl->get_location(), iterable_decl->token.text);
+	types::type_t::ref iterable_type = iterable_var->type->get_type();
+	if (auto ref_type = dyncast<const types::type_ref_t>(iterable_type)) {
+		iterable_type = ref_type->element_type;
+	}
+
+	/* vectors, strs and ranges are walked with a counted loop, which spares us an iterator
+	 * allocation up front and a Just allocation per item. everything else speaks the iterator
+	 * protocol. */
+	ptr<block_t> loop = iterator_loop;
+	auto vector_type = dyncast<const types::type_operator_t>(iterable_type);
+	if (vector_type != nullptr && types::is_type_id(vector_type->oper, STD_VECTOR_TYPE, nullptr)) {
+		loop = indexed_loop;
+	} else if (types::is_type_id(iterable_type, MANAGED_STR, nullptr)) {
+		loop = indexed_loop;
+	} else if (types::is_type_id(iterable_type, "IntRange", nullptr)) {
+		loop = range_loop;
+	}
+
+	debug_above(5, log(log_info, "lowering for loop over %s as %s",
+				iterable_type->str().c_str(),
+				loop->str().c_str()));
+
+	loop->resolve_statement(builder, iterable_scope, life, nullptr, returns);
+
+	if (returns == nullptr || !*returns) {
+		life->release_vars(builder, scope, lf_block);
+	}
+}
+
 void ast::if_block_t::resolve_statement(
         llvm::IRBuilder<> &builder,
         scope_t::ref scope,
@@ -4371,6 +4858,26 @@ void ast::var_decl_t::resolve_statement(
 }
 
 
+static ast::statement_t::ref get_inlinable_body(ast::block_t::ref block) {
+	/* returns something that can be resolved in place of calling a deferred lambda, as long
+	 * as nothing in it can return, break or continue */
+	if (block->statements.size() == 1) {
+		if (auto return_statement = dyncast<const ast::return_statement_t>(block->statements[0])) {
+			/* defer fn () => write(stdout, "done") */
+			return return_statement->expr;
+		}
+	}
+
+	for (auto &statement : block->statements) {
+		if (dyncast<const ast::callsite_expr_t>(statement) == nullptr
+				&& dyncast<const ast::assignment_t>(statement) == nullptr)
+		{
+			return nullptr;
+		}
+	}
+	return block;
+}
+
 void ast::defer_t::resolve_statement(
 		llvm::IRBuilder<> &builder,
 		scope_t::ref scope,
@@ -4378,6 +4885,39 @@ void ast::defer_t::resolve_statement(
 		runnable_scope_t::ref *new_scope,
 		bool *returns) const
 {
+	auto function_defn = dyncast<const ast::function_defn_t>(callable);
+	auto runnable_scope = dyncast<runnable_scope_t>(scope);
+	auto inlinable_body = (function_defn != nullptr) ? get_inlinable_body(function_defn->block) : nullptr;
+	if (inlinable_body != nullptr && runnable_scope != nullptr) {
+		/* defer fn () { posix.pclose(fp) } does not need a closure. type check the lambda as
+		 * usual, which also captures what it needs from this scope, and then inline its body
+		 * wherever this block is left. */
+		auto closure_name = std::string("deferred fn at ") + function_defn->token.location.repr();
+		auto closure_scope = runnable_scope->new_closure_scope(builder, closure_name);
+		auto function = function_defn->resolve_function(builder, closure_scope, life,
+				true /*as_closure*/,
+				type_deferred_function(get_location(), type_variable(get_location())),
+				nullptr, nullptr);
+
+		auto return_type = dyncast<const types::type_function_t>(function->type->get_type())->return_type;
+		if (!unifies(return_type, type_void(), scope) && !unifies(return_type, type_unit(), scope)) {
+			auto error = user_error(callable->get_location(), "deferred expression must be a function taking no arguments, and returning void or ()");
+			error.add_info(callable->get_location(), "the deferred function returns %s",
+					return_type->str().c_str());
+			throw error;
+		}
+
+		auto defer_scope = runnable_scope->new_runnable_scope(closure_name);
+		for (auto &captured_value : closure_scope->get_captured_values()) {
+			/* the closure would have kept these alive until it ran */
+			life->track_var(builder, scope, captured_value.second, lf_block);
+			defer_scope->put_bound_variable(captured_value.first, captured_value.second);
+		}
+
+		life->defer_statement(builder, defer_scope, inlinable_body);
+		return;
+	}
+
 	auto expr = callable->resolve_expression(builder,
 			scope, life, false /*as_ref*/,
 			type_deferred_function(
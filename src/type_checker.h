@@ -54,3 +54,4 @@ void resolve_assert_macro(
 		ptr<ast::expression_t> condition,
 		runnable_scope_t::ref *new_scope);
 int64_t parse_int_value(token_t token);
+const std::map<std::string, int> &get_folded_constant_counts();
@@ -12,6 +12,7 @@
 #include "phase_scope_setup.h"
 #include "types.h"
 #include "code_id.h"
+#include "unchecked_var.h"
 
 bound_var_t::ref bind_ctor_to_scope(
 		llvm::IRBuilder<> &builder,
@@ -195,6 +196,252 @@ void instantiate_data_ctor_type(
 	}
 }
 
+std::string get_type_head_name(types::type_t::ref type) {
+	/* find the name of the type constructor at the head of a (possibly applied) type */
+	while (auto type_operator = dyncast<const types::type_operator_t>(type)) {
+		type = type_operator->oper;
+	}
+	if (auto type_id = dyncast<const types::type_id_t>(type)) {
+		return type_id->id->get_name();
+	}
+	return "";
+}
+
+bool has_user_defined_function(
+		module_scope_t::ref module_scope,
+		std::string function_name,
+		std::string type_name)
+{
+	/* look for an overload of function_name whose first parameter is declared as type_name */
+	auto program_scope = module_scope->get_program_scope();
+	var_t::refs fns;
+	program_scope->get_callables(function_name, fns, true /*check_unchecked*/);
+	program_scope->get_callables(module_scope->make_fqn(function_name), fns, true /*check_unchecked*/);
+
+	for (auto fn : fns) {
+		auto unchecked_var = dyncast<const unchecked_var_t>(fn);
+		if (unchecked_var == nullptr) {
+			continue;
+		}
+
+		types::type_t::ref function_type;
+		if (auto function_defn = dyncast<const ast::function_defn_t>(unchecked_var->node)) {
+			function_type = function_defn->decl->function_type;
+		} else if (auto link_function = dyncast<const ast::link_function_statement_t>(unchecked_var->node)) {
+			function_type = link_function->extern_function->function_type;
+		}
+
+		auto type_function = dyncast<const types::type_function_t>(function_type);
+		if (type_function == nullptr) {
+			continue;
+		}
+
+		auto type_args = dyncast<const types::type_args_t>(type_function->args);
+		if (type_args != nullptr && type_args->args.size() != 0
+				&& get_type_head_name(type_args->args[0]) == type_name)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string get_derived_hash_seed(std::string type_name) {
+	/* every type starts hashing from a different place, so that values of different types with
+	 * the same fields do not all collide. this is FNV-1a over the type's name. */
+	uint64_t seed = 0xcbf29ce484222325ull;
+	for (auto ch : type_name) {
+		seed = (seed ^ (uint8_t)ch) * 0x100000001b3ull;
+	}
+	return string_format("0x%016llx", (unsigned long long)seed);
+}
+
+/* the derived functions are built straight out of AST nodes. these build the few kinds of node
+ * they need, all pointing back at the type's declaration. */
+
+token_t derived_token(location_t location, std::string name) {
+	return token_t(location, tk_identifier, name);
+}
+
+ptr<ast::expression_t> derived_ref(location_t location, std::string name) {
+	return ast::create<ast::reference_expr_t>(derived_token(location, name));
+}
+
+ptr<ast::expression_t> derived_call(
+		location_t location,
+		std::string function_name,
+		std::vector<ptr<ast::expression_t>> params)
+{
+	auto callsite = ast::create<ast::callsite_expr_t>(derived_token(location, function_name));
+	callsite->function_expr = derived_ref(location, function_name);
+	callsite->params = params;
+	return callsite;
+}
+
+ptr<ast::expression_t> derived_eq(location_t location, ptr<ast::expression_t> lhs, ptr<ast::expression_t> rhs) {
+	auto eq = ast::create<ast::binary_operator_t>(token_t(location, tk_equal, "=="));
+	eq->function_name = "__eq__";
+	eq->lhs = lhs;
+	eq->rhs = rhs;
+	return eq;
+}
+
+ptr<ast::expression_t> derived_and(location_t location, ptr<ast::expression_t> lhs, ptr<ast::expression_t> rhs) {
+	if (lhs == nullptr) {
+		return rhs;
+	}
+	auto and_expr = ast::create<ast::and_expr_t>(derived_token(location, K(and)));
+	and_expr->lhs = lhs;
+	and_expr->rhs = rhs;
+	return and_expr;
+}
+
+ptr<ast::statement_t> derived_assign(location_t location, std::string name, ptr<ast::expression_t> value) {
+	auto assignment = ast::create<ast::assignment_t>(token_t(location, tk_assign, "="));
+	assignment->lhs = derived_ref(location, name);
+	assignment->rhs = value;
+	return assignment;
+}
+
+ptr<ast::statement_t> derived_var(location_t location, std::string name, ptr<ast::expression_t> initializer) {
+	auto var_decl = ast::create<ast::var_decl_t>(derived_token(location, name));
+	var_decl->is_let_var = false;
+	var_decl->type = type_variable(location);
+	var_decl->initializer = initializer;
+	return var_decl;
+}
+
+ptr<ast::statement_t> derived_return(location_t location, ptr<ast::expression_t> expr) {
+	auto return_statement = ast::create<ast::return_statement_t>(derived_token(location, K(return)));
+	return_statement->expr = expr;
+	return return_statement;
+}
+
+ptr<ast::statement_t> derived_hash_mix(location_t location, ptr<ast::expression_t> value) {
+	/* h = __hash_combine__(h, value) */
+	return derived_assign(location, "h",
+			derived_call(location, "__hash_combine__", {derived_ref(location, "h"), value}));
+}
+
+ptr<ast::expression_t> derived_hash_of(location_t location, ptr<ast::expression_t> value) {
+	return derived_call(location, "__hash__", {value});
+}
+
+ptr<ast::block_t> derived_block(location_t location, std::vector<ptr<ast::statement_t>> statements) {
+	auto block = ast::create<ast::block_t>(derived_token(location, "{"));
+	block->statements = statements;
+	return block;
+}
+
+void put_derived_function(
+		module_scope_t::ref module_scope,
+		location_t location,
+		std::string function_name,
+		types::type_t::ref type_constraints,
+		types::type_t::ref param_type,
+		std::vector<std::string> param_names,
+		types::type_t::ref return_type,
+		std::vector<ptr<ast::statement_t>> statements)
+{
+	types::type_t::refs param_types;
+	identifier::refs param_ids;
+	for (auto &param_name : param_names) {
+		param_types.push_back(param_type);
+		param_ids.push_back(make_iid_impl(param_name, location));
+	}
+
+	/* derived functions are always [global] generics, so they are only type checked if something
+	 * calls them */
+	auto function_decl = ast::create<ast::function_decl_t>(derived_token(location, function_name));
+	function_decl->function_type = type_function(location, type_constraints,
+			type_args(param_types, param_ids), return_type);
+	function_decl->extends_module = make_iid_impl(GLOBAL_SCOPE_NAME, location);
+	function_decl->link_to_name = function_decl->token;
+
+	auto function = ast::create<ast::function_defn_t>(function_decl->token);
+	function->decl = function_decl;
+	function->block = derived_block(location, statements);
+
+	debug_above(6, log(log_info, "deriving function at %s\n%s",
+				location.str().c_str(), function->str().c_str()));
+
+	module_scope->get_program_scope()->put_unchecked_variable(
+			function_name,
+			unchecked_var_t::create(
+				make_iid_impl(function_name, location),
+				function, module_scope));
+}
+
+types::type_t::ref get_derived_param_type(
+		std::string type_name,
+		identifier::refs type_variables,
+		location_t location,
+		types::type_t::ref &type_constraints)
+{
+	/* non-generic types still get a type variable (constrained to be the type) so that the
+	 * derived function stays unchecked until it is used */
+	types::type_t::ref type = type_id(make_iid_impl(type_name, location));
+	if (type_variables.size() == 0) {
+		auto self = type_variable(make_iid_impl("Self", location));
+		type_constraints = type_eq(self, type, location);
+		return self;
+	}
+
+	type_constraints = nullptr;
+	for (auto type_variable : type_variables) {
+		type = type_operator(type, ::type_variable(type_variable));
+	}
+	return type;
+}
+
+void derive_hash_and_eq(
+		module_scope_t::ref module_scope,
+		identifier::ref id,
+		identifier::refs type_variables,
+		std::function<std::vector<ptr<ast::statement_t>> (std::string x)> hash_body,
+		std::function<std::vector<ptr<ast::statement_t>> ()> eq_body)
+{
+	/* types that do not define their own __hash__ or __eq__ get them derived structurally, so
+	 * that they work as map keys. the name is written the way this module's own code would
+	 * write it. */
+	std::string type_name = module_scope->get_leaf_name() == GLOBAL_SCOPE_NAME
+		? id->get_name()
+		: module_scope->make_fqn(id->get_name());
+	auto location = id->get_location();
+	types::type_t::ref type_constraints;
+	types::type_t::ref param_type = get_derived_param_type(type_name, type_variables, location,
+			type_constraints);
+
+	if (!has_user_defined_function(module_scope, "__hash__", type_name)) {
+		/* var h = seed; ...; return h */
+		std::vector<ptr<ast::statement_t>> statements;
+		statements.push_back(derived_var(location, "h",
+					ast::create<ast::literal_expr_t>(token_t(location, tk_integer,
+							get_derived_hash_seed(type_name)))));
+		for (auto &statement : hash_body("x")) {
+			statements.push_back(statement);
+		}
+		statements.push_back(derived_return(location, derived_ref(location, "h")));
+
+		put_derived_function(module_scope, location, "__hash__", type_constraints, param_type,
+				{"x"}, type_id(make_iid_impl(INT_TYPE, location)), statements);
+	}
+
+	if (!has_user_defined_function(module_scope, "__eq__", type_name)) {
+		put_derived_function(module_scope, location, "__eq__", type_constraints, param_type,
+				{"a", "b"}, type_id(make_iid_impl(BOOL_TYPE, location)), eq_body());
+
+		if (!has_user_defined_function(module_scope, "__ineq__", type_name)) {
+			/* return not (a == b) */
+			auto not_expr = ast::create<ast::prefix_expr_t>(derived_token(location, K(not)));
+			not_expr->rhs = derived_eq(location, derived_ref(location, "a"), derived_ref(location, "b"));
+			put_derived_function(module_scope, location, "__ineq__", type_constraints, param_type,
+					{"a", "b"}, type_id(make_iid_impl(BOOL_TYPE, location)),
+					{derived_return(location, not_expr)});
+		}
+	}
+}
+
 void ast::type_product_t::register_type(
 		llvm::IRBuilder<> &builder,
 		identifier::ref id_,
@@ -222,6 +469,46 @@ void ast::type_product_t::register_type(
 		 * unchecked data ctor for the type */
 		instantiate_data_ctor_type(builder, type,
 				type_variables, scope, shared_from_this(), id_, native);
+
+		auto module_scope = dyncast<module_scope_t>(scope);
+		auto struct_ = dyncast<const types::type_struct_t>(type);
+		if (!native && module_scope != nullptr && dyncast<const program_scope_t>(scope) == nullptr
+				&& struct_ != nullptr && struct_->name_index.size() == struct_->dimensions.size())
+		{
+			/* visit the fields in declaration order */
+			std::vector<std::string> fields(struct_->dimensions.size());
+			for (auto &name_pair : struct_->name_index) {
+				fields[name_pair.second] = name_pair.first;
+			}
+
+			derive_hash_and_eq(module_scope, id_, type_variables,
+					[&fields, location] (std::string x) {
+						/* h = __hash_combine__(h, __hash__(x.field)) for each field */
+						std::vector<ptr<ast::statement_t>> statements;
+						for (auto &field : fields) {
+							auto dot_expr = ast::create<ast::dot_expr_t>(derived_token(location, "."));
+							dot_expr->lhs = derived_ref(location, x);
+							dot_expr->rhs = derived_token(location, field);
+							statements.push_back(derived_hash_mix(location, derived_hash_of(location, dot_expr)));
+						}
+						return statements;
+					},
+					[&fields, location] () {
+						/* return a.field == b.field and ... */
+						ptr<ast::expression_t> expr;
+						for (auto &field : fields) {
+							auto a_field = ast::create<ast::dot_expr_t>(derived_token(location, "."));
+							a_field->lhs = derived_ref(location, "a");
+							a_field->rhs = derived_token(location, field);
+							auto b_field = ast::create<ast::dot_expr_t>(derived_token(location, "."));
+							b_field->lhs = derived_ref(location, "b");
+							b_field->rhs = derived_token(location, field);
+							expr = derived_and(location, expr, derived_eq(location, a_field, b_field));
+						}
+						return std::vector<ptr<ast::statement_t>>{derived_return(location,
+								expr != nullptr ? expr : derived_ref(location, "true"))};
+					});
+		}
 		return;
 	} else {
 		/* simple check for an already bound typename env variable */
@@ -247,6 +534,32 @@ types::type_t::map bottom_out_unreferenced_vars(const std::set<std::string> &see
 	return bindings;
 }
 
+ptr<ast::ctor_predicate_t> get_derived_ctor_pattern(
+		location_t location,
+		token_t ctor_token,
+		std::string prefix,
+		types::type_args_t::ref args)
+{
+	/* binds the members of a ctor to prefix_0, prefix_1, ... */
+	auto predicate = ast::create<ast::ctor_predicate_t>(derived_token(location, ctor_token.text));
+	for (int i = 0; i < int(args->args.size()); ++i) {
+		predicate->params.push_back(ast::create<ast::irrefutable_predicate_t>(
+					derived_token(location, string_format("%s_%d", prefix.c_str(), i))));
+	}
+	return predicate;
+}
+
+ptr<ast::pattern_block_t> derived_pattern_block(
+		location_t location,
+		ast::predicate_t::ref predicate,
+		std::vector<ptr<ast::statement_t>> statements)
+{
+	auto pattern_block = ast::create<ast::pattern_block_t>(predicate->token);
+	pattern_block->predicate = predicate;
+	pattern_block->block = derived_block(location, statements);
+	return pattern_block;
+}
+
 void ast::data_type_t::register_type(
 		llvm::IRBuilder<> &builder,
 		identifier::ref id,
@@ -317,6 +630,88 @@ void ast::data_type_t::register_type(
 							module_scope, data_ctor_sig, false /*native*/));
 			}
 		}
+
+		if (dyncast<const program_scope_t>(scope) == nullptr) {
+			auto location = id->get_location();
+			derive_hash_and_eq(module_scope, id, type_variables,
+					[this, location] (std::string x) {
+						/* mix in which ctor this is, then its members:
+						 *
+						 *   match x {
+						 *     Ctor(x_0, ...) {
+						 *       h = __hash_combine__(h, ctor_index)
+						 *       h = __hash_combine__(h, __hash__(x_0))
+						 *       ...
+						 *     }
+						 *     ...
+						 *   }
+						 */
+						auto match = ast::create<ast::match_expr_t>(derived_token(location, K(match)));
+						match->value = derived_ref(location, x);
+						int ctor_index = 0;
+						for (auto &ctor_pair : ctor_pairs) {
+							std::vector<ptr<ast::statement_t>> statements;
+							statements.push_back(derived_hash_mix(location,
+										ast::create<ast::literal_expr_t>(token_t(location, tk_integer,
+												string_format("%d", ctor_index++)))));
+							for (int i = 0; i < int(ctor_pair.second->args.size()); ++i) {
+								statements.push_back(derived_hash_mix(location, derived_hash_of(location,
+												derived_ref(location, string_format("%s_%d", x.c_str(), i)))));
+							}
+							match->pattern_blocks.push_back(derived_pattern_block(location,
+										get_derived_ctor_pattern(location, ctor_pair.first, x, ctor_pair.second),
+										statements));
+						}
+						return std::vector<ptr<ast::statement_t>>{match};
+					},
+					[this, location] () {
+						/* a nested match on b for each ctor of a. b's match needs an else unless
+						 * its single pattern already covers every ctor.
+						 *
+						 *   var equal = false
+						 *   match a {
+						 *     Ctor(a_0, ...) {
+						 *       match b {
+						 *         Ctor(b_0, ...) { equal = a_0 == b_0 and ... }
+						 *       } else {}
+						 *     }
+						 *     ...
+						 *   }
+						 *   return equal
+						 */
+						bool need_else = ctor_pairs.size() > 1;
+						auto match_a = ast::create<ast::match_expr_t>(derived_token(location, K(match)));
+						match_a->value = derived_ref(location, "a");
+						for (auto &ctor_pair : ctor_pairs) {
+							ptr<ast::expression_t> expr;
+							for (int i = 0; i < int(ctor_pair.second->args.size()); ++i) {
+								expr = derived_and(location, expr, derived_eq(location,
+											derived_ref(location, string_format("a_%d", i)),
+											derived_ref(location, string_format("b_%d", i))));
+							}
+
+							auto match_b = ast::create<ast::match_expr_t>(derived_token(location, K(match)));
+							match_b->value = derived_ref(location, "b");
+							match_b->pattern_blocks.push_back(derived_pattern_block(location,
+										get_derived_ctor_pattern(location, ctor_pair.first, "b", ctor_pair.second),
+										{derived_assign(location, "equal",
+											expr != nullptr ? expr : derived_ref(location, "true"))}));
+							if (need_else) {
+								match_b->pattern_blocks.push_back(derived_pattern_block(location,
+											ast::create<ast::irrefutable_predicate_t>(derived_token(location, K(else))),
+											{}));
+							}
+
+							match_a->pattern_blocks.push_back(derived_pattern_block(location,
+										get_derived_ctor_pattern(location, ctor_pair.first, "a", ctor_pair.second),
+										{match_b}));
+						}
+						return std::vector<ptr<ast::statement_t>>{
+							derived_var(location, "equal", derived_ref(location, "false")),
+							match_a,
+							derived_return(location, derived_ref(location, "equal"))};
+					});
+		}
 	} else {
 		auto error = user_error(id->get_location(), "data types cannot be registered twice");
 		error.add_info(existing_type->get_location(), "see prior type registered here");
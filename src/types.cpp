@@ -1302,7 +1302,7 @@ namespace types {
 		}
 
 		if (auto tuple_type = dyncast<const types::type_tuple_t>(type)) {
-			return true;
+			return !is_value_tuple(tuple_type, env);
 		}
 
 		if (auto ptr_type = dyncast<const types::type_ptr_t>(type)) {
@@ -1318,6 +1318,28 @@ namespace types {
 		return false;
 	}
 
+	bool is_value_tuple(types::type_t::ref type, env_t::ref _env) {
+		/* tuples with no managed members are not heap allocated. they are passed and returned by
+		 * value as llvm first-class structs, and the gc never needs to see them. the unit stays a
+		 * singleton object. */
+		env_t::ref env = (_env == nullptr) ? _empty_env : _env;
+		if (auto expanded_type = type->eval(env, true /*get_structural_type*/)) {
+			type = expanded_type;
+		}
+
+		auto tuple_type = dyncast<const types::type_tuple_t>(type);
+		if (tuple_type == nullptr || tuple_type->dimensions.size() == 0) {
+			return false;
+		}
+
+		for (auto dimension : tuple_type->dimensions) {
+			if (dimension->ftv_count() != 0 || is_managed_ptr(dimension, env)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	bool is_ptr(types::type_t::ref type, env_t::ref env) {
 		// REVIEW: this is nebulous, it really depends on what env is passed in
 		type = type->eval(env, true /*get_structural_type*/);
@@ -183,6 +183,7 @@ namespace types {
 	bool is_type_id(type_t::ref type, const std::string &type_name, env_t::ref env);
 	bool is_ptr_type_id(type_t::ref type, const std::string &type_name, env_t::ref env, bool allow_maybe=false);
 	bool is_managed_ptr(types::type_t::ref type, env_t::ref env);
+	bool is_value_tuple(types::type_t::ref type, env_t::ref env);
 	bool is_ptr(types::type_t::ref type, env_t::ref env);
 
 	struct type_id_t : public type_t {
@@ -17,6 +17,8 @@
 //===----------------------------------------------------------------------===//
 #include "zion.h"
 #include "dbg.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/CodeGen/GCStrategy.h"
 #include "llvm/CodeGen/Passes.h"
@@ -54,6 +56,18 @@ class ZionGCLowering : public FunctionPass {
   /// intrinsic call and its corresponding alloca.
   std::vector<std::pair<CallInst *, AllocaInst *>> Roots;
 
+  /// MayCollect - Functions that can reach a collection (or let another thread
+  /// collect while they wait). Everything else can keep its roots to itself.
+  SmallPtrSet<const Function *, 64> MayCollect;
+
+  /// NumFrames, NumFramesDropped - Counts of functions with roots, and of
+  /// those that got by without a shadow stack entry. Logged by doFinalization.
+  unsigned NumFrames;
+  unsigned NumFramesDropped;
+
+  /// KeepAllFrames - Set by ZION_GC_KEEP_FRAMES to turn off frame elision.
+  bool KeepAllFrames;
+
 public:
   static char ID;
   ZionGCLowering();
@@ -61,12 +75,15 @@ public:
 
   bool doInitialization(Module &M) override;
   bool runOnFunction(Function &F) override;
+  bool doFinalization(Module &M) override;
 
 private:
   bool IsNullValue(Value *V);
   Constant *GetFrameMap(Function &F);
   Type *GetConcreteStackEntryType(Function &F);
   void CollectRoots(Function &F);
+  void FindCollectingFunctions(Module &M);
+  static bool CalleeMayCollect(CallSite CS, const Function *Callee);
   static GetElementPtrInst *CreateGEP(LLVMContext &Context, IRBuilder<> &B,
                                       Type *Ty, Value *BasePtr, int Idx1,
                                       const char *Name);
@@ -87,7 +104,8 @@ char ZionGCLowering::ID = 0;
 ZionGCLowering::ZionGCLowering() : ZionGCLowering(nullptr, nullptr) {}
 ZionGCLowering::ZionGCLowering(StructType *StackEntryTy, StructType *FrameMapTy)
   : FunctionPass(ID), Head(nullptr), StackEntryTy(StackEntryTy),
-    FrameMapTy(FrameMapTy) {
+    FrameMapTy(FrameMapTy), NumFrames(0), NumFramesDropped(0),
+    KeepAllFrames(false) {
   initializeZionGCLoweringPass(*PassRegistry::getPassRegistry());
 }
 
@@ -145,6 +163,10 @@ Type *ZionGCLowering::GetConcreteStackEntryType(Function &F) {
 /// doInitialization - If this module uses the GC intrinsics, find them now. If
 /// not, exit fast.
 bool ZionGCLowering::doInitialization(Module &M) {
+  NumFrames = 0;
+  NumFramesDropped = 0;
+  KeepAllFrames = false;
+
   bool Active = false;
   for (Function &F : M) {
     if (F.hasGC() && F.getGC() == std::string("zion")) {
@@ -171,9 +193,106 @@ bool ZionGCLowering::doInitialization(Module &M) {
     Head->setLinkage(GlobalValue::LinkOnceAnyLinkage);
   }
 
+  // Every thread gets its own shadow stack (see lib/thread.zion). The linker
+  // relaxes the general dynamic TLS model to local exec for executables.
+  Head->setThreadLocal(true);
+
+  // ZION_GC_KEEP_FRAMES gives every function with roots a frame again, which
+  // is only useful for measuring what dropping them saves.
+  if (getenv("ZION_GC_KEEP_FRAMES") == nullptr)
+    FindCollectingFunctions(M);
+  else
+    KeepAllFrames = true;
   return true;
 }
 
+bool ZionGCLowering::doFinalization(Module &M) {
+  debug_above(2, log("%d of %d functions with gc roots in %s need no gc frame",
+        (int)NumFramesDropped, (int)NumFrames, M.getName().str().c_str()));
+  return false;
+}
+
+/// CalleeMayCollect - Whether calling Callee may start a collection, not
+/// counting whatever Callee itself calls.
+bool ZionGCLowering::CalleeMayCollect(CallSite CS, const Function *Callee) {
+  if (Callee == nullptr) {
+    // We can't see through indirect calls.
+    return true;
+  }
+
+  StringRef Name = Callee->getName();
+  if (Name.startswith("runtime.create_var") || Name.startswith("runtime.gc")) {
+    return true;
+  }
+
+  if (!Callee->isDeclaration()) {
+    return false;
+  }
+
+  if (Callee->hasGC()) {
+    // A zion function defined in some other module.
+    return true;
+  }
+
+  if (Name.startswith("__rt_")) {
+    // Thread safepoints and blocking calls, which let other threads collect.
+    return true;
+  }
+
+  // Otherwise this is a C function, which can only get back into zion code
+  // through a function pointer.
+  for (Value *Arg : CS.args()) {
+    Type *ArgTy = Arg->getType();
+    if (isa<Function>(Arg->stripPointerCasts()) ||
+        (ArgTy->isPointerTy() && ArgTy->getPointerElementType()->isFunctionTy())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// FindCollectingFunctions - Propagate "may collect" up the call graph, so
+/// that functions which can never see a collection (leaves like str.__eq__ or
+/// vector.__getitem__) skip the shadow stack entirely.
+void ZionGCLowering::FindCollectingFunctions(Module &M) {
+  MayCollect.clear();
+
+  DenseMap<const Function *, SmallVector<const Function *, 4>> Callers;
+  SmallVector<const Function *, 64> Worklist;
+
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+
+    bool Collects = false;
+    for (BasicBlock &BB : F) {
+      for (Instruction &I : BB) {
+        CallSite CS(&I);
+        if (!CS || isa<IntrinsicInst>(I))
+          continue;
+
+        const Function *Callee = dyn_cast<Function>(
+            CS.getCalledValue()->stripPointerCasts());
+        if (CalleeMayCollect(CS, Callee))
+          Collects = true;
+        else if (!Callee->isDeclaration())
+          Callers[Callee].push_back(&F);
+      }
+    }
+
+    if (Collects && MayCollect.insert(&F).second)
+      Worklist.push_back(&F);
+  }
+
+  while (!Worklist.empty()) {
+    const Function *F = Worklist.pop_back_val();
+    for (const Function *Caller : Callers[F]) {
+      if (MayCollect.insert(Caller).second)
+        Worklist.push_back(Caller);
+    }
+  }
+}
+
 bool ZionGCLowering::IsNullValue(Value *V) {
   if (Constant *C = dyn_cast<Constant>(V))
     return C->isNullValue();
@@ -257,6 +376,18 @@ bool ZionGCLowering::runOnFunction(Function &F) {
   if (Roots.empty())
     return false;
 
+  ++NumFrames;
+  if (!KeepAllFrames && !MayCollect.count(&F)) {
+    ++NumFramesDropped;
+    // Nothing can collect while this function is running, so its roots don't
+    // need to be visible. Leave the allocas as plain locals.
+    debug_above(4, log("%s needs no gc frame", F.getName().str().c_str()));
+    for (unsigned I = 0, E = Roots.size(); I != E; ++I)
+      Roots[I].first->eraseFromParent();
+    Roots.clear();
+    return true;
+  }
+
   // Build the constant map and figure the type of the shadow stack entry.
   Value *FrameMap = GetFrameMap(F);
   Type *ConcreteStackEntryTy = GetConcreteStackEntryType(F);
@@ -307,9 +438,23 @@ bool ZionGCLowering::runOnFunction(Function &F) {
   AtEntry.CreateStore(CurrentHead, EntryNextPtr);
   AtEntry.CreateStore(NewHeadVal, Head);
 
+  // Calls marked musttail (see mark_sibling_tail_call) must be followed
+  // directly by their ret, and can't be turned into invokes. Zion code doesn't
+  // unwind, so functions with such calls skip the unwind cleanups.
+  bool HasMustTailCall = false;
+  for (BasicBlock &BB : F)
+    if (BB.getTerminatingMustTailCall())
+      HasMustTailCall = true;
+
   // For each instruction that escapes...
-  EscapeEnumerator EE(F, "gc_cleanup");
+  EscapeEnumerator EE(F, "gc_cleanup", !HasMustTailCall);
   while (IRBuilder<> *AtExit = EE.Next()) {
+    // A tail call hands the frame over to its callee, so pop our entry
+    // before the call rather than between the call and the ret.
+    if (ReturnInst *RI = dyn_cast<ReturnInst>(&*AtExit->GetInsertPoint()))
+      if (CallInst *CI = RI->getParent()->getTerminatingMustTailCall())
+        AtExit->SetInsertPoint(CI);
+
     // Pop the entry from the shadow stack. Don't reuse CurrentHead from
     // AtEntry, since that would make the value live for the entire function.
     Instruction *EntryNextPtr2 =
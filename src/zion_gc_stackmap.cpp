@@ -0,0 +1,110 @@
+//===-- ZionGCStackMap.cpp - Stack map strategy for zion gc ---===//
+//
+// This file contains the "zion-stackmap" GC strategy, an alternative to the
+// shadow stack built by ZionGCLowering. Functions keep their gcroot allocas
+// where they are, and the code generator records which frame slots are live
+// after every call. Those are written out to a static frame table that the
+// collector uses to walk the native stack (see src/rt_gc.c), so calls no
+// longer pay for pushing and popping a shadow stack entry.
+//
+// The frame table is modelled on the one OCaml uses. Each module emits one
+// table into the "zion_frametable" section, and the linker gathers them all
+// between __start_zion_frametable and __stop_zion_frametable:
+//
+//   uint64_t descriptor_count
+//   descriptor_count times:
+//     void    *return_address   (the address just after the call)
+//     uint32_t live_count
+//     int32_t  live_offsets[live_count]   (relative to the frame pointer)
+//     (padding to pointer alignment)
+//
+// Since the offsets are relative to the frame pointer, every function using
+// this strategy must keep one (see run_gc_lowering in compiler.cpp).
+//
+//===----------------------------------------------------------------------===//
+#include "zion.h"
+#include "dbg.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/CodeGen/AsmPrinter.h"
+#include "llvm/CodeGen/GCMetadata.h"
+#include "llvm/CodeGen/GCMetadataPrinter.h"
+#include "llvm/CodeGen/GCStrategy.h"
+#include "llvm/IR/Module.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCSectionELF.h"
+#include "llvm/MC/MCStreamer.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Target/TargetLoweringObjectFile.h"
+#include "llvm/Target/TargetMachine.h"
+
+#define GC_STACK_MAP_SECTION "zion_frametable"
+
+using namespace llvm;
+
+namespace {
+
+class ZionStackMapGC : public GCStrategy {
+public:
+	ZionStackMapGC() {
+		/* let the generic gcroot lowering null out the roots on entry, and
+		 * ask for a safe point after every call */
+		InitRoots = true;
+		UsesMetadata = true;
+		NeededSafePoints = 1 << GC::PostCall;
+	}
+};
+
+class ZionStackMapPrinter : public GCMetadataPrinter {
+public:
+	void finishAssembly(Module &M, GCModuleInfo &Info, AsmPrinter &AP) override;
+};
+
+}
+
+static GCRegistry::Add<ZionStackMapGC> C("zion-stackmap", "Zion GC with static stack maps");
+static GCMetadataPrinterRegistry::Add<ZionStackMapPrinter> P("zion-stackmap", "Zion GC frame table printer");
+
+void ZionStackMapPrinter::finishAssembly(Module &M, GCModuleInfo &Info, AsmPrinter &AP) {
+	if (!AP.TM.getTargetTriple().isOSBinFormatELF()) {
+		report_fatal_error("the zion-stackmap gc strategy only supports ELF targets");
+	}
+
+	unsigned IntPtrSize = M.getDataLayout().getPointerSize();
+	unsigned PtrAlignment = IntPtrSize == 4 ? 2 : 3;
+
+	uint64_t NumDescriptors = 0;
+	for (auto I = Info.funcinfo_begin(), IE = Info.funcinfo_end(); I != IE; ++I) {
+		GCFunctionInfo &FI = **I;
+		if (FI.getStrategy().getName() == getStrategy().getName()) {
+			NumDescriptors += FI.size();
+		}
+	}
+
+	MCSection *Section = AP.OutContext.getELFSection(
+			GC_STACK_MAP_SECTION,
+			ELF::SHT_PROGBITS,
+			ELF::SHF_ALLOC | ELF::SHF_WRITE);
+	AP.OutStreamer->SwitchSection(Section);
+	AP.EmitAlignment(PtrAlignment);
+	AP.OutStreamer->EmitIntValue(NumDescriptors, 8);
+
+	for (auto I = Info.funcinfo_begin(), IE = Info.funcinfo_end(); I != IE; ++I) {
+		GCFunctionInfo &FI = **I;
+		if (FI.getStrategy().getName() != getStrategy().getName()) {
+			continue;
+		}
+
+		debug_above(6, log("writing %d stack map descriptors for %s",
+					(int)FI.size(), FI.getFunction().getName().str().c_str()));
+
+		for (auto J = FI.begin(), JE = FI.end(); J != JE; ++J) {
+			AP.OutStreamer->EmitSymbolValue(J->Label, IntPtrSize);
+			AP.EmitInt32(FI.live_size(J));
+
+			for (auto K = FI.live_begin(J), KE = FI.live_end(J); K != KE; ++K) {
+				AP.EmitInt32(K->StackOffset);
+			}
+			AP.EmitAlignment(PtrAlignment);
+		}
+	}
+}
@@ -0,0 +1,323 @@
+//===-- ZionStackPromotion.cpp - Keep non-escaping objects off the heap ---===//
+//
+// Every data constructor allocates its object with runtime.create_var, which
+// links it into the heap, and leaves it for the collector to free. Plenty of
+// those objects never leave the function that built them: a temporary
+// KeyValue, an IntRange that is only read for its bounds, a Just that is
+// matched right away.
+//
+// This pass looks at each call to a constructor that the code generator
+// marked as promotable (one whose fields are all numbers or pointers, and has
+// no finalizer). If the object it returns cannot escape the calling function,
+// the constructor is inlined and its create_var call becomes an alloca in the
+// entry block.
+//
+// An object escapes if a pointer to it is returned, stored anywhere but into
+// a local alloca whose address does not itself escape, or passed to a call.
+// The calls that don't count are runtime.__get_ctor_id, calls to the closure
+// the object is (with itself as the environment), and calls to a known
+// function that doesn't let that param escape in turn. That last one is what
+// keeps the closure for a lambda passed to foldl off the heap. Locals holding the object may be gc
+// roots. Stack objects have an allocation number of 0. mark_allocation in
+// lib/runtime.zion never marks them, since they are in no heap region, but it
+// does trace their fields. An object with pointer fields gets a gc root of
+// its own, set once it is built, so that the collector finds it even when no
+// local holds it. It can't point at another stack object, since storing a
+// pointer into an object escapes it.
+//
+// Each stack object owns one alloca for the whole call, so constructors that
+// run inside a loop are left alone. Otherwise an object from one iteration
+// could still be reachable through a local while the next iteration reuses
+// its memory.
+//
+//===----------------------------------------------------------------------===//
+#include "zion.h"
+#include "dbg.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm_utils.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "zion-stack-promotion"
+
+/// MaxCalleeDepth - How many calls deep Escapes follows an object.
+static const unsigned MaxCalleeDepth = 3;
+
+namespace {
+
+class ZionStackPromotion : public FunctionPass {
+  /// NumCtorCalls, NumPromoted - Counts for the whole module, logged by
+  /// doFinalization.
+  unsigned NumCtorCalls;
+  unsigned NumPromoted;
+
+public:
+  static char ID;
+  ZionStackPromotion();
+
+  bool doInitialization(Module &M) override;
+  bool runOnFunction(Function &F) override;
+  bool doFinalization(Module &M) override;
+
+private:
+  static bool IsPromotableCtorCall(CallInst *CI);
+  static bool IsInCycle(BasicBlock *BB);
+  static bool Escapes(Value *Object, unsigned Depth = 0);
+  static Type *GetObjectType(CallInst *Alloc);
+  static bool HoldsPointers(Function *Ctor);
+  bool Promote(Function &F, CallInst *CtorCall);
+};
+}
+
+char ZionStackPromotion::ID = 0;
+
+ZionStackPromotion::ZionStackPromotion()
+    : FunctionPass(ID), NumCtorCalls(0), NumPromoted(0) {}
+
+bool ZionStackPromotion::doInitialization(Module &M) {
+  NumCtorCalls = 0;
+  NumPromoted = 0;
+  return false;
+}
+
+bool ZionStackPromotion::doFinalization(Module &M) {
+  debug_above(2, log("promoted %d of %d constructor calls in %s to the stack",
+        (int)NumPromoted, (int)NumCtorCalls, M.getName().str().c_str()));
+  return false;
+}
+
+bool ZionStackPromotion::IsPromotableCtorCall(CallInst *CI) {
+  Function *Callee = CI->getCalledFunction();
+  return Callee != nullptr && !Callee->isDeclaration() &&
+         Callee->hasFnAttribute(PROMOTABLE_CTOR_ATTR);
+}
+
+/// IsInCycle - Whether control can come back around to BB once it has left.
+bool ZionStackPromotion::IsInCycle(BasicBlock *BB) {
+  SmallVector<BasicBlock *, 16> Worklist(succ_begin(BB), succ_end(BB));
+  SmallPtrSet<BasicBlock *, 32> Visited;
+  while (!Worklist.empty()) {
+    BasicBlock *Succ = Worklist.pop_back_val();
+    if (Succ == BB)
+      return true;
+    if (Visited.insert(Succ).second)
+      Worklist.append(succ_begin(Succ), succ_end(Succ));
+  }
+  return false;
+}
+
+/// Escapes - Whether the object that Object points to can be reached from
+/// anywhere but this function's own frame. Depth counts the known callees
+/// that Object has been followed into, as one of their params.
+bool ZionStackPromotion::Escapes(Value *Object, unsigned Depth) {
+  // Pointers to (or into) the object, and the locals that hold them.
+  SmallVector<Value *, 16> Pointers;
+  SmallVector<Value *, 8> Slots;
+  SmallPtrSet<Value *, 32> Visited;
+  SmallVector<CallInst *, 4> ClosureCalls;
+
+  Pointers.push_back(Object);
+  while (!Pointers.empty() || !Slots.empty()) {
+    if (!Slots.empty()) {
+      Value *Slot = Slots.pop_back_val();
+      if (!Visited.insert(Slot).second)
+        continue;
+
+      for (User *U : Slot->users()) {
+        if (auto *LI = dyn_cast<LoadInst>(U)) {
+          Pointers.push_back(LI);
+        } else if (auto *SI = dyn_cast<StoreInst>(U)) {
+          if (SI->getValueOperand() == Slot)
+            return true;
+        } else if (isa<BitCastInst>(U)) {
+          Slots.push_back(U);
+        } else if (auto *II = dyn_cast<IntrinsicInst>(U)) {
+          if (II->getIntrinsicID() != Intrinsic::gcroot)
+            return true;
+        } else {
+          return true;
+        }
+      }
+      continue;
+    }
+
+    Value *Pointer = Pointers.pop_back_val();
+    if (!Visited.insert(Pointer).second)
+      continue;
+
+    for (User *U : Pointer->users()) {
+      if (isa<BitCastInst>(U) || isa<GetElementPtrInst>(U) ||
+          isa<PHINode>(U) || isa<SelectInst>(U)) {
+        Pointers.push_back(U);
+      } else if (isa<LoadInst>(U) || isa<ICmpInst>(U)) {
+        // Reading a field, or comparing the pointer itself.
+      } else if (auto *SI = dyn_cast<StoreInst>(U)) {
+        if (SI->getValueOperand() != Pointer)
+          continue;
+
+        // Storing the pointer is only fine if it goes into a local.
+        Value *Dest = SI->getPointerOperand();
+        if (Dest == Pointer || !isa<AllocaInst>(Dest->stripPointerCasts()))
+          return true;
+        Slots.push_back(Dest->stripPointerCasts());
+      } else if (auto *CI = dyn_cast<CallInst>(U)) {
+        Function *Callee = CI->getCalledFunction();
+        if (CI->isMustTailCall() || CI->getCalledValue() == Pointer)
+          return true;
+        if (Callee != nullptr &&
+            Callee->getName().startswith("runtime.__get_ctor_id"))
+          continue;
+
+        if (Callee == nullptr) {
+          // Calling a closure passes the closure itself as the last argument,
+          // its environment. Lambda bodies only ever read their captures out
+          // of it, so that's fine, as long as the function being called was
+          // loaded out of this same object. That is checked below, once all
+          // of the pointers to the object are known.
+          for (unsigned I = 0, E = CI->getNumArgOperands(); I != E; ++I)
+            if (CI->getArgOperand(I) == Pointer && I + 1 != E)
+              return true;
+          ClosureCalls.push_back(CI);
+          continue;
+        }
+
+        // Handing the object to a known function is fine if that function
+        // doesn't let it escape either, the way foldl only calls its binop.
+        if (Depth >= MaxCalleeDepth || Callee->isDeclaration() ||
+            Callee->isVarArg())
+          return true;
+        for (unsigned I = 0, E = CI->getNumArgOperands(); I != E; ++I)
+          if (CI->getArgOperand(I) == Pointer &&
+              Escapes(&*std::next(Callee->arg_begin(), I), Depth + 1))
+            return true;
+      } else {
+        return true;
+      }
+    }
+  }
+
+  for (CallInst *CI : ClosureCalls) {
+    auto *FnLoad = dyn_cast<LoadInst>(CI->getCalledValue()->stripPointerCasts());
+    if (FnLoad == nullptr ||
+        !Visited.count(FnLoad->getPointerOperand()->stripInBoundsOffsets()))
+      return true;
+  }
+  return false;
+}
+
+/// GetObjectType - The full type of the object that a constructor allocates,
+/// as it casts the result of create_var.
+Type *ZionStackPromotion::GetObjectType(CallInst *Alloc) {
+  const DataLayout &DL = Alloc->getModule()->getDataLayout();
+  Type *ObjectTy = Alloc->getType()->getPointerElementType();
+  for (User *U : Alloc->users()) {
+    if (auto *BC = dyn_cast<BitCastInst>(U)) {
+      Type *CastTy = BC->getDestTy()->getPointerElementType();
+      if (CastTy->isSized() &&
+          DL.getTypeAllocSize(CastTy) > DL.getTypeAllocSize(ObjectTy))
+        ObjectTy = CastTy;
+    }
+  }
+  return ObjectTy;
+}
+
+/// HoldsPointers - Whether the constructor stores any pointers into the object.
+bool ZionStackPromotion::HoldsPointers(Function *Ctor) {
+  for (Argument &Arg : Ctor->args())
+    if (Arg.getType()->isPointerTy())
+      return true;
+  return false;
+}
+
+bool ZionStackPromotion::Promote(Function &F, CallInst *CtorCall) {
+  bool NeedsRoot = HoldsPointers(CtorCall->getCalledFunction());
+  InlineFunctionInfo IFI;
+  if (!InlineFunction(CallSite(CtorCall), IFI))
+    return false;
+
+  CallInst *Alloc = nullptr;
+  for (WeakTrackingVH &VH : IFI.InlinedCalls) {
+    auto *CI = dyn_cast_or_null<CallInst>(VH);
+    if (CI != nullptr && CI->getCalledFunction() != nullptr &&
+        CI->getCalledFunction()->getName().startswith("runtime.create_var")) {
+      Alloc = CI;
+      break;
+    }
+  }
+  assert(Alloc != nullptr && "promotable ctors allocate with create_var");
+
+  Type *ObjectTy = GetObjectType(Alloc);
+
+  IRBuilder<> Entry(&F.getEntryBlock(), F.getEntryBlock().getFirstInsertionPt());
+  AllocaInst *Object = Entry.CreateAlloca(ObjectTy, nullptr, "stack.object");
+
+  // Same as create_var, but the header is zeroed, so allocation is 0 and the
+  // object is never linked into a heap region.
+  IRBuilder<> B(Alloc);
+  B.CreateStore(Constant::getNullValue(ObjectTy), Object);
+  Value *Var = B.CreateBitCast(Object, Alloc->getType());
+  Value *TypeInfoSlot = B.CreateStructGEP(nullptr, Var, 0, "stack.object.type_info");
+  B.CreateStore(
+      B.CreateBitCast(Alloc->getArgOperand(0),
+                      TypeInfoSlot->getType()->getPointerElementType()),
+      TypeInfoSlot);
+
+  if (NeedsRoot) {
+    // Root the object for the rest of the call. gcroots must be allocas in the
+    // entry block, and start out null.
+    Module *M = F.getParent();
+    Type *RootPtrTy = Type::getInt8PtrTy(F.getContext())->getPointerTo();
+    AllocaInst *Root = Entry.CreateAlloca(Var->getType(), nullptr, "stack.object.root");
+    Entry.CreateCall(Intrinsic::getDeclaration(M, Intrinsic::gcroot),
+                     {Entry.CreateBitCast(Root, RootPtrTy),
+                      ConstantPointerNull::get(Type::getInt8PtrTy(F.getContext()))});
+    Entry.CreateStore(Constant::getNullValue(Var->getType()), Root);
+    B.CreateStore(Var, Root);
+  }
+
+  Alloc->replaceAllUsesWith(Var);
+  Alloc->eraseFromParent();
+  return true;
+}
+
+bool ZionStackPromotion::runOnFunction(Function &F) {
+  SmallVector<CallInst *, 16> Candidates;
+  for (BasicBlock &BB : F) {
+    for (Instruction &I : BB) {
+      auto *CI = dyn_cast<CallInst>(&I);
+      if (CI == nullptr || !IsPromotableCtorCall(CI))
+        continue;
+
+      ++NumCtorCalls;
+      if (!IsInCycle(&BB) && !Escapes(CI))
+        Candidates.push_back(CI);
+    }
+  }
+
+  bool Changed = false;
+  for (CallInst *CI : Candidates) {
+    if (Promote(F, CI)) {
+      ++NumPromoted;
+      Changed = true;
+    }
+  }
+
+  if (Changed) {
+    debug_above(4, log("%s keeps some of its objects on the stack",
+          F.getName().str().c_str()));
+  }
+  return Changed;
+}
+
+namespace llvm {
+	FunctionPass *createZionStackPromotionPass() {
+		return new ZionStackPromotion();
+	}
+}